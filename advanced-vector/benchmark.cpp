@@ -0,0 +1,263 @@
+#include "vector.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Move constructor is not noexcept, so Vector and std::vector copy it on reallocation
+    struct ThrowingMoveObj {
+
+        ThrowingMoveObj() = default;
+
+        explicit ThrowingMoveObj(int id) : id(id), name(std::to_string(id)) {}
+
+        ThrowingMoveObj(const ThrowingMoveObj& other) = default;
+
+        ThrowingMoveObj(ThrowingMoveObj&& other) noexcept(false) : id(other.id), name(std::move(other.name)) {}
+
+        ThrowingMoveObj& operator=(const ThrowingMoveObj& other) = default;
+        ThrowingMoveObj& operator=(ThrowingMoveObj&& other) = default;
+
+        int id = 0;
+        std::string name;
+    };
+
+    template<typename T>
+    T MakeValue(size_t i) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            // Long enough to defeat the small string optimization
+            return std::string(32, static_cast<char>('a' + i % 26));
+        }
+        else if constexpr (std::is_same_v<T, ThrowingMoveObj>) {
+            return ThrowingMoveObj(static_cast<int>(i));
+        }
+        else {
+            return static_cast<T>(i);
+        }
+    }
+
+    // Adapters that let every benchmark body run against both containers
+
+    template<typename T>
+    void PushBack(Vector<T>& v, T value) {v.PushBack(std::move(value));}
+
+    template<typename T>
+    void PushBack(std::vector<T>& v, T value) {v.push_back(std::move(value));}
+
+    template<typename T>
+    void EmplaceBack(Vector<T>& v, size_t i) {v.EmplaceBack(MakeValue<T>(i));}
+
+    template<typename T>
+    void EmplaceBack(std::vector<T>& v, size_t i) {v.emplace_back(MakeValue<T>(i));}
+
+    template<typename T>
+    void Reserve(Vector<T>& v, size_t n) {v.Reserve(n);}
+
+    template<typename T>
+    void Reserve(std::vector<T>& v, size_t n) {v.reserve(n);}
+
+    template<typename T>
+    void Insert(Vector<T>& v, size_t index, T value) {v.Insert(v.begin() + index, std::move(value));}
+
+    template<typename T>
+    void Insert(std::vector<T>& v, size_t index, T value) {v.insert(v.begin() + index, std::move(value));}
+
+    template<typename T>
+    void Erase(Vector<T>& v, size_t index) {v.Erase(v.begin() + index);}
+
+    template<typename T>
+    void Erase(std::vector<T>& v, size_t index) {v.erase(v.begin() + index);}
+
+    template<typename T>
+    size_t Size(const Vector<T>& v) {return v.Size();}
+
+    template<typename T>
+    size_t Size(const std::vector<T>& v) {return v.size();}
+
+    template<typename Container>
+    Container MakeContainer(size_t n) {
+        using T = typename Container::value_type;
+        Container v;
+        Reserve(v, n);
+        for (size_t i = 0; i < n; ++i) {
+            PushBack(v, MakeValue<T>(i));
+        }
+        return v;
+    }
+
+    enum class Position {Front, Middle, End};
+
+    size_t IndexFor(Position position, size_t size) {
+        switch (position) {
+            case Position::Front:
+                return 0;
+            case Position::Middle:
+                return size / 2;
+            case Position::End:
+                return size;
+        }
+        return size;
+    }
+
+}//end namespace
+
+template<typename Container>
+static void BM_PushBack(benchmark::State& state) {
+    using T = typename Container::value_type;
+    const auto n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < n; ++i) {
+            PushBack(v, MakeValue<T>(i));
+        }
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename Container>
+static void BM_EmplaceBack(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < n; ++i) {
+            EmplaceBack(v, i);
+        }
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename Container>
+static void BM_ReserveThenPushBack(benchmark::State& state) {
+    using T = typename Container::value_type;
+    const auto n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Container v;
+        Reserve(v, n);
+        for (size_t i = 0; i < n; ++i) {
+            PushBack(v, MakeValue<T>(i));
+        }
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename Container>
+static void BM_Reserve(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = MakeContainer<Container>(n);
+        state.ResumeTiming();
+        Reserve(v, n * 2);
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename Container, Position position>
+static void BM_Insert(benchmark::State& state) {
+    using T = typename Container::value_type;
+    const auto n = static_cast<size_t>(state.range(0));
+    auto v = MakeContainer<Container>(n);
+    size_t i = 0;
+    for (auto _ : state) {
+        Insert(v, IndexFor(position, Size(v)), MakeValue<T>(i++));
+        Erase(v, IndexFor(position, Size(v) - 1));
+    }
+    benchmark::DoNotOptimize(v);
+}
+
+template<typename Container, Position position>
+static void BM_Erase(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = MakeContainer<Container>(n);
+        state.ResumeTiming();
+        for (size_t i = 0; i < n / 2; ++i) {
+            Erase(v, IndexFor(position, Size(v) - 1));
+        }
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.iterations() * (state.range(0) / 2));
+}
+
+template<typename Container>
+static void BM_CopyAssign(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto source = MakeContainer<Container>(n);
+    Container v;
+    for (auto _ : state) {
+        v = source;
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename Container>
+static void BM_MoveAssign(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    auto a = MakeContainer<Container>(n);
+    Container b;
+    for (auto _ : state) {
+        b = std::move(a);
+        a = std::move(b);
+        benchmark::DoNotOptimize(a);
+    }
+}
+
+template<typename Container>
+static void BM_Iterate(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto v = MakeContainer<Container>(n);
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (const auto& elem : v) {
+            if constexpr (std::is_arithmetic_v<typename Container::value_type>) {
+                sum += static_cast<size_t>(elem);
+            }
+            else if constexpr (std::is_same_v<typename Container::value_type, std::string>) {
+                sum += elem.size();
+            }
+            else {
+                sum += static_cast<size_t>(elem.id);
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define ADVANCED_VECTOR_BENCHMARK(name, type)                                        \
+    BENCHMARK_TEMPLATE(name, Vector<type>)->RangeMultiplier(16)->Range(16, 1 << 20);      \
+    BENCHMARK_TEMPLATE(name, std::vector<type>)->RangeMultiplier(16)->Range(16, 1 << 20)
+
+#define ADVANCED_VECTOR_POSITION_BENCHMARK(name, type, position)                     \
+    BENCHMARK_TEMPLATE(name, Vector<type>, position)->RangeMultiplier(16)->Range(16, 1 << 16); \
+    BENCHMARK_TEMPLATE(name, std::vector<type>, position)->RangeMultiplier(16)->Range(16, 1 << 16)
+
+#define ADVANCED_VECTOR_BENCHMARK_ALL(type)                                          \
+    ADVANCED_VECTOR_BENCHMARK(BM_PushBack, type);                                    \
+    ADVANCED_VECTOR_BENCHMARK(BM_EmplaceBack, type);                                 \
+    ADVANCED_VECTOR_BENCHMARK(BM_ReserveThenPushBack, type);                         \
+    ADVANCED_VECTOR_BENCHMARK(BM_Reserve, type);                                     \
+    ADVANCED_VECTOR_POSITION_BENCHMARK(BM_Insert, type, Position::Front);            \
+    ADVANCED_VECTOR_POSITION_BENCHMARK(BM_Insert, type, Position::Middle);           \
+    ADVANCED_VECTOR_POSITION_BENCHMARK(BM_Insert, type, Position::End);              \
+    ADVANCED_VECTOR_POSITION_BENCHMARK(BM_Erase, type, Position::Front);             \
+    ADVANCED_VECTOR_POSITION_BENCHMARK(BM_Erase, type, Position::Middle);            \
+    ADVANCED_VECTOR_POSITION_BENCHMARK(BM_Erase, type, Position::End);               \
+    ADVANCED_VECTOR_BENCHMARK(BM_CopyAssign, type);                                  \
+    ADVANCED_VECTOR_BENCHMARK(BM_MoveAssign, type);                                  \
+    ADVANCED_VECTOR_BENCHMARK(BM_Iterate, type)
+
+ADVANCED_VECTOR_BENCHMARK_ALL(int);
+ADVANCED_VECTOR_BENCHMARK_ALL(std::string);
+ADVANCED_VECTOR_BENCHMARK_ALL(ThrowingMoveObj);
+
+BENCHMARK_MAIN();
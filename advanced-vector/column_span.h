@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+// Contiguous view of a run of elements: a column of an SoAVector or a segment of a RingVector
+template<typename T>
+class ColumnSpan {
+public:
+	ColumnSpan(T* data, size_t size) noexcept : data_(data), size_(size) {}
+
+	T* begin() const noexcept {return data_;}
+
+	T* end() const noexcept {return data_ + size_;}
+
+	T* Data() const noexcept {return data_;}
+
+	size_t Size() const noexcept {return size_;}
+
+	T& operator[](size_t index) const noexcept {
+		assert(index < size_);
+		return data_[index];
+	}
+
+private:
+	T* data_;
+
+	size_t size_;
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "segment_layout.h"
+
+#include <new>
+#include <atomic>
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <type_traits>
+
+// Append-only vector for many concurrent producers. EmplaceBack claims an index with a single
+// atomic increment and constructs the element in a segment of doubling size, so elements never
+// move and the storage never grows under a lock. A missing segment is allocated by whichever
+// thread needs it first: it claims the segment slot with a marker, and threads needing the same
+// segment meanwhile wait for it to be installed instead of allocating copies of their own.
+//
+// An element becomes visible to readers when its construction is published: IsPublished(index)
+// and operator[] may run concurrently with appends and never see a half-built element. An index
+// whose construction threw is never published and stays empty.
+template<typename T, unsigned FirstShift = 5>
+class ConcurrentVector {
+	using Layout = SegmentLayout<FirstShift>;
+
+public:
+	using value_type = T;
+
+	ConcurrentVector() noexcept = default;
+
+	ConcurrentVector(const ConcurrentVector&) = delete;
+
+	ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+	~ConcurrentVector();
+
+	// Returns the index of the new element
+	template<typename... Args>
+	size_t EmplaceBack(Args&&... args);
+
+	size_t PushBack(const T& value);
+
+	size_t PushBack(T&& value);
+
+	// Allocates the segments for capacity elements ahead of time
+	void Reserve(size_t capacity);
+
+	// Number of claimed indices, including elements still being constructed by other threads
+	size_t Size() const noexcept;
+
+	bool IsPublished(size_t index) const noexcept;
+
+	// The element must be published
+	T& operator[](size_t index) noexcept;
+
+	const T& operator[](size_t index) const noexcept;
+
+	// Calls f(index, element) for every published element; may run concurrently with appends
+	template<typename F>
+	void ForEachPublished(F&& f) const;
+
+private:
+	// A segment is a single block: the elements followed by one publication flag per element
+	static size_t SegmentBytes(size_t segment) noexcept;
+
+	static std::atomic<bool>* Flags(T* segment_data, size_t segment) noexcept;
+
+	T* Segment(size_t segment);
+
+	T* AllocateSegment(size_t segment);
+
+	// Marker held by the slot of a segment while one thread allocates it
+	static T* Allocating() noexcept;
+
+	// True for a slot holding an allocated segment
+	static bool IsInstalled(const T* data) noexcept;
+
+	static void DeallocateSegment(T* data, size_t segment) noexcept;
+
+	std::atomic<T*> segments_[Layout::kMaxSegments] = {};
+
+	std::atomic<size_t> size_{0};
+};
+
+template<typename T, unsigned FirstShift>
+ConcurrentVector<T, FirstShift>::~ConcurrentVector() {
+	size_t size = size_.load(std::memory_order_acquire);
+	for (size_t segment = 0; segment < Layout::kMaxSegments; ++segment) {
+		T* data = segments_[segment].load(std::memory_order_acquire);
+		if (!IsInstalled(data)) {
+			continue;
+		}
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			std::atomic<bool>* flags = Flags(data, segment);
+			size_t start = Layout::SegmentStart(segment);
+			size_t count = size > start ? std::min(size - start, Layout::SegmentSize(segment)) : 0;
+			for (size_t i = 0; i < count; ++i) {
+				if (flags[i].load(std::memory_order_relaxed)) {
+					std::destroy_at(data + i);
+				}
+			}
+		}
+		DeallocateSegment(data, segment);
+	}
+}
+
+template<typename T, unsigned FirstShift>
+template<typename... Args>
+size_t ConcurrentVector<T, FirstShift>::EmplaceBack(Args&&... args) {
+	size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+	size_t segment = Layout::SegmentOf(index);
+	size_t offset = Layout::OffsetOf(index);
+	T* data = Segment(segment);
+	new (data + offset) T(std::forward<Args>(args)...);
+	Flags(data, segment)[offset].store(true, std::memory_order_release);
+	return index;
+}
+
+template<typename T, unsigned FirstShift>
+size_t ConcurrentVector<T, FirstShift>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, unsigned FirstShift>
+size_t ConcurrentVector<T, FirstShift>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, unsigned FirstShift>
+void ConcurrentVector<T, FirstShift>::Reserve(size_t capacity) {
+	for (size_t segment = 0; segment < Layout::SegmentCount(capacity); ++segment) {
+		Segment(segment);
+	}
+}
+
+template<typename T, unsigned FirstShift>
+size_t ConcurrentVector<T, FirstShift>::Size() const noexcept {
+	return size_.load(std::memory_order_acquire);
+}
+
+template<typename T, unsigned FirstShift>
+bool ConcurrentVector<T, FirstShift>::IsPublished(size_t index) const noexcept {
+	size_t segment = Layout::SegmentOf(index);
+	T* data = segments_[segment].load(std::memory_order_acquire);
+	return IsInstalled(data) && Flags(data, segment)[Layout::OffsetOf(index)].load(std::memory_order_acquire);
+}
+
+template<typename T, unsigned FirstShift>
+T& ConcurrentVector<T, FirstShift>::operator[](size_t index) noexcept {
+	assert(IsPublished(index));
+	return segments_[Layout::SegmentOf(index)].load(std::memory_order_acquire)[Layout::OffsetOf(index)];
+}
+
+template<typename T, unsigned FirstShift>
+const T& ConcurrentVector<T, FirstShift>::operator[](size_t index) const noexcept {
+	return const_cast<ConcurrentVector&>(*this)[index];
+}
+
+template<typename T, unsigned FirstShift>
+template<typename F>
+void ConcurrentVector<T, FirstShift>::ForEachPublished(F&& f) const {
+	size_t size = Size();
+	for (size_t segment = 0; segment < Layout::SegmentCount(size); ++segment) {
+		T* data = segments_[segment].load(std::memory_order_acquire);
+		if (!IsInstalled(data)) {
+			continue;
+		}
+		std::atomic<bool>* flags = Flags(data, segment);
+		size_t start = Layout::SegmentStart(segment);
+		size_t count = std::min(size - start, Layout::SegmentSize(segment));
+		for (size_t i = 0; i < count; ++i) {
+			if (flags[i].load(std::memory_order_acquire)) {
+				f(start + i, static_cast<const T&>(data[i]));
+			}
+		}
+	}
+}
+
+template<typename T, unsigned FirstShift>
+size_t ConcurrentVector<T, FirstShift>::SegmentBytes(size_t segment) noexcept {
+	return Layout::SegmentSize(segment) * (sizeof(T) + sizeof(std::atomic<bool>));
+}
+
+template<typename T, unsigned FirstShift>
+std::atomic<bool>* ConcurrentVector<T, FirstShift>::Flags(T* segment_data, size_t segment) noexcept {
+	return reinterpret_cast<std::atomic<bool>*>(segment_data + Layout::SegmentSize(segment));
+}
+
+template<typename T, unsigned FirstShift>
+T* ConcurrentVector<T, FirstShift>::Segment(size_t segment) {
+	T* data = segments_[segment].load(std::memory_order_acquire);
+	return IsInstalled(data) ? data : AllocateSegment(segment);
+}
+
+template<typename T, unsigned FirstShift>
+T* ConcurrentVector<T, FirstShift>::AllocateSegment(size_t segment) {
+	std::atomic<T*>& slot = segments_[segment];
+	T* expected = nullptr;
+	while (!slot.compare_exchange_weak(expected, Allocating(), std::memory_order_acquire)) {
+		if (IsInstalled(expected)) {
+			return expected;
+		}
+		if (expected == Allocating()) {
+			// Another thread is allocating the segment; if its allocation fails the slot is
+			// cleared and this thread tries in turn
+			std::this_thread::yield();
+			expected = nullptr;
+		}
+	}
+	T* data = nullptr;
+	try {
+		data = static_cast<T*>(operator new(SegmentBytes(segment), std::align_val_t{alignof(T)}));
+	}
+	catch (...) {
+		slot.store(nullptr, std::memory_order_release);
+		throw;
+	}
+	std::atomic<bool>* flags = Flags(data, segment);
+	for (size_t i = 0; i < Layout::SegmentSize(segment); ++i) {
+		new (flags + i) std::atomic<bool>(false);
+	}
+	slot.store(data, std::memory_order_release);
+	return data;
+}
+
+template<typename T, unsigned FirstShift>
+T* ConcurrentVector<T, FirstShift>::Allocating() noexcept {
+	// Never dereferenced, only compared
+	return reinterpret_cast<T*>(alignof(T));
+}
+
+template<typename T, unsigned FirstShift>
+bool ConcurrentVector<T, FirstShift>::IsInstalled(const T* data) noexcept {
+	return data != nullptr && data != Allocating();
+}
+
+template<typename T, unsigned FirstShift>
+void ConcurrentVector<T, FirstShift>::DeallocateSegment(T* data, size_t segment) noexcept {
+	operator delete(data, SegmentBytes(segment), std::align_val_t{alignof(T)});
+}
@@ -0,0 +1,358 @@
+#pragma once
+
+#include "vector.h"
+
+#include <atomic>
+
+// Vector with copy-on-write sharing. Copies share one reference-counted buffer, so publishing a
+// snapshot to reader threads costs an atomic increment instead of copying the elements. The
+// first mutating call on a shared instance (anything non-const, including non-const operator[]
+// and begin()) copies the elements into a buffer of its own.
+//
+// Different CowVector objects sharing a buffer may be used from different threads. A reference
+// or iterator obtained through a non-const call must not be used after the CowVector is copied,
+// because the copy shares the buffer it points into.
+template<typename T>
+class CowVector {
+public:
+	using value_type = T;
+
+	using iterator = T*;
+
+	using const_iterator = const T*;
+
+	CowVector() noexcept = default;
+
+	explicit CowVector(size_t size);
+
+	explicit CowVector(Vector<T> data);
+
+	CowVector(const CowVector& other) noexcept;
+
+	CowVector(CowVector&& other) noexcept;
+
+	~CowVector();
+
+	CowVector& operator=(const CowVector& rhs) noexcept;
+
+	CowVector& operator=(CowVector&& rhs) noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	iterator begin();
+
+	iterator end();
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	const T* Data() const noexcept;
+
+	// Number of CowVector objects sharing the buffer, 0 for an empty object without one
+	size_t UseCount() const noexcept;
+
+	void Swap(CowVector& other) noexcept;
+
+	void Reserve(size_t new_capacity);
+
+	void Resize(size_t new_size);
+
+	// Drops this object's reference to a shared buffer instead of copying it
+	void Clear() noexcept;
+
+	template<typename... Args>
+	T& EmplaceBack(Args&&... args);
+
+	T& PushBack(const T& value);
+
+	T& PushBack(T&& value);
+
+	void PopBack();
+
+	template<typename... Args>
+	iterator Emplace(const_iterator pos, Args&&... args);
+
+	iterator Insert(const_iterator pos, const T& value);
+
+	iterator Insert(const_iterator pos, T&& value);
+
+	iterator Erase(const_iterator pos);
+
+	iterator Erase(const_iterator first, const_iterator last);
+
+	const T& operator[](size_t index) const noexcept;
+
+	T& operator[](size_t index);
+
+	// Read-only access to the current contents without unsharing
+	const Vector<T>& Get() const noexcept;
+
+private:
+	struct Buffer {
+		explicit Buffer(Vector<T> vector) noexcept : data(std::move(vector)) {}
+
+		std::atomic<size_t> refs{1};
+
+		Vector<T> data;
+	};
+
+	static const Vector<T>& Empty() noexcept;
+
+	void Release() noexcept;
+
+	// Makes the buffer exclusively owned, copying it when shared, with room for capacity elements
+	Vector<T>& Mutable(size_t capacity = 0);
+
+	// Keeps an iterator into the shared buffer pointing at the same index after unsharing
+	size_t IndexOf(const_iterator pos) const noexcept;
+
+	Buffer* buffer_ = nullptr;
+};
+
+template<typename T>
+CowVector<T>::CowVector(size_t size)
+	: CowVector(Vector<T>(size))
+{
+}
+
+template<typename T>
+CowVector<T>::CowVector(Vector<T> data)
+	: buffer_(new Buffer(std::move(data)))
+{
+}
+
+template<typename T>
+CowVector<T>::CowVector(const CowVector& other) noexcept
+	: buffer_(other.buffer_)
+{
+	if (buffer_ != nullptr) {
+		buffer_->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+template<typename T>
+CowVector<T>::CowVector(CowVector&& other) noexcept
+	: buffer_(std::exchange(other.buffer_, nullptr))
+{
+}
+
+template<typename T>
+CowVector<T>::~CowVector() {
+	Release();
+}
+
+template<typename T>
+CowVector<T>& CowVector<T>::operator=(const CowVector& rhs) noexcept {
+	CowVector copy(rhs);
+	Swap(copy);
+	return *this;
+}
+
+template<typename T>
+CowVector<T>& CowVector<T>::operator=(CowVector&& rhs) noexcept {
+	if (this != &rhs) {
+		Release();
+		buffer_ = std::exchange(rhs.buffer_, nullptr);
+	}
+	return *this;
+}
+
+template<typename T>
+typename CowVector<T>::const_iterator CowVector<T>::begin() const noexcept {
+	return Get().Data();
+}
+
+template<typename T>
+typename CowVector<T>::const_iterator CowVector<T>::end() const noexcept {
+	return Get().Data() + Get().Size();
+}
+
+template<typename T>
+typename CowVector<T>::const_iterator CowVector<T>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename T>
+typename CowVector<T>::const_iterator CowVector<T>::cend() const noexcept {
+	return end();
+}
+
+template<typename T>
+typename CowVector<T>::iterator CowVector<T>::begin() {
+	return Mutable().begin();
+}
+
+template<typename T>
+typename CowVector<T>::iterator CowVector<T>::end() {
+	return Mutable().end();
+}
+
+template<typename T>
+size_t CowVector<T>::Size() const noexcept {
+	return Get().Size();
+}
+
+template<typename T>
+size_t CowVector<T>::Capacity() const noexcept {
+	return Get().Capacity();
+}
+
+template<typename T>
+const T* CowVector<T>::Data() const noexcept {
+	return Get().Data();
+}
+
+template<typename T>
+size_t CowVector<T>::UseCount() const noexcept {
+	return buffer_ != nullptr ? buffer_->refs.load(std::memory_order_relaxed) : 0;
+}
+
+template<typename T>
+void CowVector<T>::Swap(CowVector& other) noexcept {
+	std::swap(buffer_, other.buffer_);
+}
+
+template<typename T>
+void CowVector<T>::Reserve(size_t new_capacity) {
+	Mutable(new_capacity).Reserve(new_capacity);
+}
+
+template<typename T>
+void CowVector<T>::Resize(size_t new_size) {
+	Mutable(new_size).Resize(new_size);
+}
+
+template<typename T>
+void CowVector<T>::Clear() noexcept {
+	if (UseCount() > 1) {
+		Release();
+	}
+	else if (buffer_ != nullptr) {
+		buffer_->data.Clear();
+	}
+}
+
+template<typename T>
+template<typename... Args>
+T& CowVector<T>::EmplaceBack(Args&&... args) {
+	// Unsharing copies the argument's source too, so build the element before the copy
+	if (UseCount() > 1) {
+		T value(std::forward<Args>(args)...);
+		return Mutable(Size() + 1).EmplaceBack(std::move(value));
+	}
+	return Mutable().EmplaceBack(std::forward<Args>(args)...);
+}
+
+template<typename T>
+T& CowVector<T>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T>
+T& CowVector<T>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T>
+void CowVector<T>::PopBack() {
+	assert(Size() > 0);
+	Mutable().PopBack();
+}
+
+template<typename T>
+template<typename... Args>
+typename CowVector<T>::iterator CowVector<T>::Emplace(const_iterator pos, Args&&... args) {
+	size_t index = IndexOf(pos);
+	if (UseCount() > 1) {
+		T value(std::forward<Args>(args)...);
+		Vector<T>& data = Mutable(Size() + 1);
+		return data.Emplace(data.begin() + index, std::move(value));
+	}
+	Vector<T>& data = Mutable();
+	return data.Emplace(data.begin() + index, std::forward<Args>(args)...);
+}
+
+template<typename T>
+typename CowVector<T>::iterator CowVector<T>::Insert(const_iterator pos, const T& value) {
+	return Emplace(pos, value);
+}
+
+template<typename T>
+typename CowVector<T>::iterator CowVector<T>::Insert(const_iterator pos, T&& value) {
+	return Emplace(pos, std::move(value));
+}
+
+template<typename T>
+typename CowVector<T>::iterator CowVector<T>::Erase(const_iterator pos) {
+	size_t index = IndexOf(pos);
+	Vector<T>& data = Mutable();
+	return data.Erase(data.begin() + index);
+}
+
+template<typename T>
+typename CowVector<T>::iterator CowVector<T>::Erase(const_iterator first, const_iterator last) {
+	size_t index = IndexOf(first);
+	size_t count = static_cast<size_t>(last - first);
+	Vector<T>& data = Mutable();
+	return data.Erase(data.begin() + index, data.begin() + index + count);
+}
+
+template<typename T>
+const T& CowVector<T>::operator[](size_t index) const noexcept {
+	return Get()[index];
+}
+
+template<typename T>
+T& CowVector<T>::operator[](size_t index) {
+	return Mutable()[index];
+}
+
+template<typename T>
+const Vector<T>& CowVector<T>::Get() const noexcept {
+	return buffer_ != nullptr ? buffer_->data : Empty();
+}
+
+template<typename T>
+const Vector<T>& CowVector<T>::Empty() noexcept {
+	static const Vector<T> empty;
+	return empty;
+}
+
+template<typename T>
+void CowVector<T>::Release() noexcept {
+	Buffer* buffer = std::exchange(buffer_, nullptr);
+	// The last owner must see every write the other owners made before letting go
+	if (buffer != nullptr && buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete buffer;
+	}
+}
+
+template<typename T>
+Vector<T>& CowVector<T>::Mutable(size_t capacity) {
+	if (buffer_ == nullptr) {
+		buffer_ = new Buffer(Vector<T>());
+	}
+	else if (buffer_->refs.load(std::memory_order_acquire) != 1) {
+		const Vector<T>& shared = buffer_->data;
+		Vector<T> copy;
+		copy.Reserve(std::max(capacity, shared.Size()));
+		copy.Append(shared.begin(), shared.end());
+		auto* unique = new Buffer(std::move(copy));
+		Release();
+		buffer_ = unique;
+	}
+	return buffer_->data;
+}
+
+template<typename T>
+size_t CowVector<T>::IndexOf(const_iterator pos) const noexcept {
+	assert(pos >= begin() && pos <= end());
+	return static_cast<size_t>(pos - begin());
+}
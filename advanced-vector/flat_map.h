@@ -0,0 +1,744 @@
+#pragma once
+
+#include "vector.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace flat_map_detail {
+
+	// Binary search that halves the range with a conditional move instead of a branch, so the
+	// loop runs log2(size) iterations without mispredictions. Returns the first element not less than key
+	template<typename T, typename Key, typename Compare>
+	const T* LowerBound(const T* first, size_t size, const Key& key, const Compare& comp) {
+		while (size > 1) {
+			size_t half = size / 2;
+			first = comp(first[half], key) ? first + half : first;
+			size -= half;
+		}
+		return first + (size == 1 && comp(*first, key));
+	}
+
+	// The first element greater than key
+	template<typename T, typename Key, typename Compare>
+	const T* UpperBound(const T* first, size_t size, const Key& key, const Compare& comp) {
+		while (size > 1) {
+			size_t half = size / 2;
+			first = !comp(key, first[half]) ? first + half : first;
+			size -= half;
+		}
+		return first + (size == 1 && !comp(key, *first));
+	}
+
+}//end namespace flat_map_detail
+
+// Ordered set of unique keys in a sorted Vector. Lookups are a branchless binary search over
+// contiguous keys; insertion and erasure shift the tail like Vector::Insert and Vector::Erase.
+// Building from a range sorts once and drops duplicates, and range Insert merges the new keys
+// with the existing ones instead of inserting them one by one. Of equivalent keys the one
+// already in the set, or the first one in the range, is kept.
+template<typename K, typename Compare = std::less<K>>
+class FlatSet {
+public:
+	using value_type = K;
+
+	using iterator = const K*;
+
+	using const_iterator = const K*;
+
+	FlatSet() = default;
+
+	explicit FlatSet(const Compare& comp);
+
+	explicit FlatSet(Vector<K> keys, const Compare& comp = Compare());
+
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	FlatSet(InputIt first, InputIt last, const Compare& comp = Compare());
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	size_t Size() const noexcept;
+
+	void Reserve(size_t new_capacity);
+
+	void Clear() noexcept;
+
+	// Returns end() when the key is missing
+	const_iterator Find(const K& key) const;
+
+	bool Contains(const K& key) const;
+
+	size_t Count(const K& key) const;
+
+	const_iterator LowerBound(const K& key) const;
+
+	const_iterator UpperBound(const K& key) const;
+
+	// Returns the element with the key and whether it was inserted
+	std::pair<iterator, bool> Insert(const K& key);
+
+	std::pair<iterator, bool> Insert(K&& key);
+
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	void Insert(InputIt first, InputIt last);
+
+	// Returns the number of removed keys, 0 or 1
+	size_t Erase(const K& key);
+
+	iterator Erase(const_iterator pos);
+
+	// The keys in ascending order
+	const Vector<K>& Keys() const noexcept;
+
+private:
+	template<typename KeyArg>
+	std::pair<iterator, bool> InsertKey(KeyArg&& key);
+
+	// Sorts keys and drops all but the first of each run of equivalent keys
+	void SortUnique(Vector<K>& keys) const;
+
+	Vector<K> keys_;
+
+	Compare comp_;
+};
+
+// Ordered map with unique keys kept in a sorted Vector and the values in a parallel Vector, so a
+// lookup searches densely packed keys only. Iterators yield std::pair<const K&, V&> by value and
+// support structured bindings: for (auto [key, value] : map). Construction from a range and range
+// Insert sort the new entries once and merge them in one pass. Of equivalent keys the one already
+// in the map, or the first one in the range, is kept.
+template<typename K, typename V, typename Compare = std::less<K>>
+class FlatMap {
+	template<bool Const>
+	class Iterator;
+
+public:
+	using key_type = K;
+
+	using mapped_type = V;
+
+	using value_type = std::pair<K, V>;
+
+	using iterator = Iterator<false>;
+
+	using const_iterator = Iterator<true>;
+
+	FlatMap() = default;
+
+	explicit FlatMap(const Compare& comp);
+
+	// Builds from a range of key-value pairs
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	FlatMap(InputIt first, InputIt last, const Compare& comp = Compare());
+
+	iterator begin() noexcept;
+
+	iterator end() noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	size_t Size() const noexcept;
+
+	void Reserve(size_t new_capacity);
+
+	void Clear() noexcept;
+
+	// Returns end() when the key is missing
+	iterator Find(const K& key);
+
+	const_iterator Find(const K& key) const;
+
+	bool Contains(const K& key) const;
+
+	size_t Count(const K& key) const;
+
+	iterator LowerBound(const K& key);
+
+	const_iterator LowerBound(const K& key) const;
+
+	// Throws std::out_of_range when the key is missing
+	V& At(const K& key);
+
+	const V& At(const K& key) const;
+
+	// Inserts a value-initialized value when the key is missing
+	V& operator[](const K& key);
+
+	V& operator[](K&& key);
+
+	// Constructs the value from args only when the key is missing, otherwise args are left untouched.
+	// Returns the element with the key and whether it was inserted
+	template<typename... Args>
+	std::pair<iterator, bool> Emplace(const K& key, Args&&... args);
+
+	template<typename... Args>
+	std::pair<iterator, bool> Emplace(K&& key, Args&&... args);
+
+	template<typename M>
+	std::pair<iterator, bool> InsertOrAssign(const K& key, M&& value);
+
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	void Insert(InputIt first, InputIt last);
+
+	// Returns the number of removed elements, 0 or 1
+	size_t Erase(const K& key);
+
+	iterator Erase(const_iterator pos);
+
+	// The keys in ascending order
+	const Vector<K>& Keys() const noexcept;
+
+	// The values in the order of their keys
+	Vector<V>& Values() noexcept;
+
+	const Vector<V>& Values() const noexcept;
+
+private:
+	// Index of the first key not less than key
+	size_t LowerIndex(const K& key) const;
+
+	bool IsKeyAt(size_t index, const K& key) const;
+
+	template<typename KeyArg, typename... Args>
+	std::pair<iterator, bool> EmplaceKey(KeyArg&& key, Args&&... args);
+
+	// Sorts entries, drops their duplicates and merges them with the elements into new buffers.
+	// All comparisons run before any element moves, and the existing elements are moved only
+	// when that cannot throw, so an exception leaves the map unchanged
+	void Merge(Vector<std::pair<K, V>>& entries);
+
+	Vector<K> keys_;
+
+	Vector<V> values_;
+
+	Compare comp_;
+};
+
+template<typename K, typename V, typename Compare>
+template<bool Const>
+class FlatMap<K, V, Compare>::Iterator {
+	using Owner = std::conditional_t<Const, const FlatMap, FlatMap>;
+
+	using ValueRef = std::conditional_t<Const, const V&, V&>;
+
+public:
+	using iterator_category = std::random_access_iterator_tag;
+
+	using value_type = std::pair<K, V>;
+
+	using difference_type = ptrdiff_t;
+
+	using pointer = void;
+
+	using reference = std::pair<const K&, ValueRef>;
+
+	Iterator() noexcept = default;
+
+	Iterator(Owner* owner, size_t index) noexcept : owner_(owner), index_(index) {}
+
+	// iterator converts to const_iterator
+	template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+	Iterator(const Iterator<OtherConst>& other) noexcept : owner_(other.owner_), index_(other.index_) {}
+
+	reference operator*() const noexcept {return {Key(), Value()};}
+
+	reference operator[](difference_type n) const noexcept {return *(*this + n);}
+
+	const K& Key() const noexcept {return owner_->keys_[index_];}
+
+	ValueRef Value() const noexcept {return owner_->values_[index_];}
+
+	Iterator& operator++() noexcept {++index_; return *this;}
+
+	Iterator operator++(int) noexcept {Iterator old = *this; ++index_; return old;}
+
+	Iterator& operator--() noexcept {--index_; return *this;}
+
+	Iterator operator--(int) noexcept {Iterator old = *this; --index_; return old;}
+
+	Iterator& operator+=(difference_type n) noexcept {index_ += n; return *this;}
+
+	Iterator& operator-=(difference_type n) noexcept {index_ -= n; return *this;}
+
+	friend Iterator operator+(Iterator it, difference_type n) noexcept {return it += n;}
+
+	friend Iterator operator+(difference_type n, Iterator it) noexcept {return it += n;}
+
+	friend Iterator operator-(Iterator it, difference_type n) noexcept {return it -= n;}
+
+	friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+		return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+	}
+
+	friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ == rhs.index_;}
+
+	friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ != rhs.index_;}
+
+	friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ < rhs.index_;}
+
+	friend bool operator>(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ > rhs.index_;}
+
+	friend bool operator<=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ <= rhs.index_;}
+
+	friend bool operator>=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ >= rhs.index_;}
+
+private:
+	friend class Iterator<!Const>;
+
+	friend class FlatMap;
+
+	Owner* owner_ = nullptr;
+
+	size_t index_ = 0;
+};
+
+template<typename K, typename Compare>
+FlatSet<K, Compare>::FlatSet(const Compare& comp)
+	: comp_(comp)
+{
+}
+
+template<typename K, typename Compare>
+FlatSet<K, Compare>::FlatSet(Vector<K> keys, const Compare& comp)
+	: keys_(std::move(keys)), comp_(comp)
+{
+	SortUnique(keys_);
+}
+
+template<typename K, typename Compare>
+template<typename InputIt, typename>
+FlatSet<K, Compare>::FlatSet(InputIt first, InputIt last, const Compare& comp)
+	: comp_(comp)
+{
+	keys_.Append(first, last);
+	SortUnique(keys_);
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::begin() const noexcept {
+	return keys_.begin();
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::end() const noexcept {
+	return keys_.end();
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::cend() const noexcept {
+	return end();
+}
+
+template<typename K, typename Compare>
+size_t FlatSet<K, Compare>::Size() const noexcept {
+	return keys_.Size();
+}
+
+template<typename K, typename Compare>
+void FlatSet<K, Compare>::Reserve(size_t new_capacity) {
+	keys_.Reserve(new_capacity);
+}
+
+template<typename K, typename Compare>
+void FlatSet<K, Compare>::Clear() noexcept {
+	keys_.Clear();
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::Find(const K& key) const {
+	const_iterator it = LowerBound(key);
+	return it != end() && !comp_(key, *it) ? it : end();
+}
+
+template<typename K, typename Compare>
+bool FlatSet<K, Compare>::Contains(const K& key) const {
+	return Find(key) != end();
+}
+
+template<typename K, typename Compare>
+size_t FlatSet<K, Compare>::Count(const K& key) const {
+	return Contains(key) ? 1 : 0;
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::LowerBound(const K& key) const {
+	return flat_map_detail::LowerBound(keys_.Data(), keys_.Size(), key, comp_);
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::UpperBound(const K& key) const {
+	return flat_map_detail::UpperBound(keys_.Data(), keys_.Size(), key, comp_);
+}
+
+template<typename K, typename Compare>
+std::pair<typename FlatSet<K, Compare>::iterator, bool> FlatSet<K, Compare>::Insert(const K& key) {
+	return InsertKey(key);
+}
+
+template<typename K, typename Compare>
+std::pair<typename FlatSet<K, Compare>::iterator, bool> FlatSet<K, Compare>::Insert(K&& key) {
+	return InsertKey(std::move(key));
+}
+
+template<typename K, typename Compare>
+template<typename InputIt, typename>
+void FlatSet<K, Compare>::Insert(InputIt first, InputIt last) {
+	// The new keys are sorted apart and merged into a new buffer, so an exception leaves the set unchanged
+	Vector<K> added;
+	added.Append(first, last);
+	SortUnique(added);
+	// Where each new key goes, SIZE_MAX if the set has it already; no comparison runs once keys move
+	Vector<size_t> positions(added.Size());
+	size_t new_count = 0;
+	for (size_t i = 0; i < added.Size(); ++i) {
+		const K* it = flat_map_detail::LowerBound(keys_.Data(), keys_.Size(), added[i], comp_);
+		bool present = it != keys_.end() && !comp_(added[i], *it);
+		positions[i] = present ? SIZE_MAX : static_cast<size_t>(it - keys_.Data());
+		new_count += present ? 0 : 1;
+	}
+	if (new_count == 0) {
+		return;
+	}
+	Vector<K> merged;
+	merged.Reserve(keys_.Size() + new_count);
+	size_t index = 0;
+	for (size_t i = 0; i < added.Size(); ++i) {
+		if (positions[i] == SIZE_MAX) {
+			continue;
+		}
+		for (; index < positions[i]; ++index) {
+			merged.EmplaceBackUnchecked(std::move_if_noexcept(keys_[index]));
+		}
+		merged.EmplaceBackUnchecked(std::move(added[i]));
+	}
+	for (; index < keys_.Size(); ++index) {
+		merged.EmplaceBackUnchecked(std::move_if_noexcept(keys_[index]));
+	}
+	keys_.Swap(merged);
+}
+
+template<typename K, typename Compare>
+size_t FlatSet<K, Compare>::Erase(const K& key) {
+	const_iterator it = Find(key);
+	if (it == end()) {
+		return 0;
+	}
+	Erase(it);
+	return 1;
+}
+
+template<typename K, typename Compare>
+typename FlatSet<K, Compare>::iterator FlatSet<K, Compare>::Erase(const_iterator pos) {
+	return keys_.Erase(pos);
+}
+
+template<typename K, typename Compare>
+const Vector<K>& FlatSet<K, Compare>::Keys() const noexcept {
+	return keys_;
+}
+
+template<typename K, typename Compare>
+template<typename KeyArg>
+std::pair<typename FlatSet<K, Compare>::iterator, bool> FlatSet<K, Compare>::InsertKey(KeyArg&& key) {
+	const_iterator it = LowerBound(key);
+	if (it != end() && !comp_(key, *it)) {
+		return {it, false};
+	}
+	return {keys_.Emplace(it, std::forward<KeyArg>(key)), true};
+}
+
+template<typename K, typename Compare>
+void FlatSet<K, Compare>::SortUnique(Vector<K>& keys) const {
+	// Stable sorting keeps the key that came first at the front of each run of equivalent keys
+	std::stable_sort(keys.begin(), keys.end(), comp_);
+	K* unique_end = std::unique(keys.begin(), keys.end(), [this](const K& lhs, const K& rhs) {
+		return !comp_(lhs, rhs);
+	});
+	keys.Erase(unique_end, keys.end());
+}
+
+template<typename K, typename V, typename Compare>
+FlatMap<K, V, Compare>::FlatMap(const Compare& comp)
+	: comp_(comp)
+{
+}
+
+template<typename K, typename V, typename Compare>
+template<typename InputIt, typename>
+FlatMap<K, V, Compare>::FlatMap(InputIt first, InputIt last, const Compare& comp)
+	: comp_(comp)
+{
+	Insert(first, last);
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::iterator FlatMap<K, V, Compare>::begin() noexcept {
+	return {this, 0};
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::iterator FlatMap<K, V, Compare>::end() noexcept {
+	return {this, keys_.Size()};
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::const_iterator FlatMap<K, V, Compare>::begin() const noexcept {
+	return {this, 0};
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::const_iterator FlatMap<K, V, Compare>::end() const noexcept {
+	return {this, keys_.Size()};
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::const_iterator FlatMap<K, V, Compare>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::const_iterator FlatMap<K, V, Compare>::cend() const noexcept {
+	return end();
+}
+
+template<typename K, typename V, typename Compare>
+size_t FlatMap<K, V, Compare>::Size() const noexcept {
+	return keys_.Size();
+}
+
+template<typename K, typename V, typename Compare>
+void FlatMap<K, V, Compare>::Reserve(size_t new_capacity) {
+	keys_.Reserve(new_capacity);
+	values_.Reserve(new_capacity);
+}
+
+template<typename K, typename V, typename Compare>
+void FlatMap<K, V, Compare>::Clear() noexcept {
+	keys_.Clear();
+	values_.Clear();
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::iterator FlatMap<K, V, Compare>::Find(const K& key) {
+	size_t index = LowerIndex(key);
+	return IsKeyAt(index, key) ? iterator{this, index} : end();
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::const_iterator FlatMap<K, V, Compare>::Find(const K& key) const {
+	return const_cast<FlatMap&>(*this).Find(key);
+}
+
+template<typename K, typename V, typename Compare>
+bool FlatMap<K, V, Compare>::Contains(const K& key) const {
+	return IsKeyAt(LowerIndex(key), key);
+}
+
+template<typename K, typename V, typename Compare>
+size_t FlatMap<K, V, Compare>::Count(const K& key) const {
+	return Contains(key) ? 1 : 0;
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::iterator FlatMap<K, V, Compare>::LowerBound(const K& key) {
+	return {this, LowerIndex(key)};
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::const_iterator FlatMap<K, V, Compare>::LowerBound(const K& key) const {
+	return {this, LowerIndex(key)};
+}
+
+template<typename K, typename V, typename Compare>
+V& FlatMap<K, V, Compare>::At(const K& key) {
+	size_t index = LowerIndex(key);
+	if (!IsKeyAt(index, key)) {
+		throw std::out_of_range("FlatMap::At: missing key");
+	}
+	return values_[index];
+}
+
+template<typename K, typename V, typename Compare>
+const V& FlatMap<K, V, Compare>::At(const K& key) const {
+	return const_cast<FlatMap&>(*this).At(key);
+}
+
+template<typename K, typename V, typename Compare>
+V& FlatMap<K, V, Compare>::operator[](const K& key) {
+	return EmplaceKey(key).first.Value();
+}
+
+template<typename K, typename V, typename Compare>
+V& FlatMap<K, V, Compare>::operator[](K&& key) {
+	return EmplaceKey(std::move(key)).first.Value();
+}
+
+template<typename K, typename V, typename Compare>
+template<typename... Args>
+std::pair<typename FlatMap<K, V, Compare>::iterator, bool> FlatMap<K, V, Compare>::Emplace(const K& key, Args&&... args) {
+	return EmplaceKey(key, std::forward<Args>(args)...);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename... Args>
+std::pair<typename FlatMap<K, V, Compare>::iterator, bool> FlatMap<K, V, Compare>::Emplace(K&& key, Args&&... args) {
+	return EmplaceKey(std::move(key), std::forward<Args>(args)...);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename M>
+std::pair<typename FlatMap<K, V, Compare>::iterator, bool> FlatMap<K, V, Compare>::InsertOrAssign(const K& key, M&& value) {
+	size_t index = LowerIndex(key);
+	if (IsKeyAt(index, key)) {
+		values_[index] = std::forward<M>(value);
+		return {iterator{this, index}, false};
+	}
+	return EmplaceKey(key, std::forward<M>(value));
+}
+
+template<typename K, typename V, typename Compare>
+template<typename InputIt, typename>
+void FlatMap<K, V, Compare>::Insert(InputIt first, InputIt last) {
+	Vector<std::pair<K, V>> entries;
+	if constexpr (std::is_base_of_v<std::forward_iterator_tag, IteratorCategory<InputIt>>) {
+		entries.Reserve(static_cast<size_t>(std::distance(first, last)));
+	}
+	for (; first != last; ++first) {
+		entries.EmplaceBack(*first);
+	}
+	Merge(entries);
+}
+
+template<typename K, typename V, typename Compare>
+size_t FlatMap<K, V, Compare>::Erase(const K& key) {
+	size_t index = LowerIndex(key);
+	if (!IsKeyAt(index, key)) {
+		return 0;
+	}
+	Erase(const_iterator{this, index});
+	return 1;
+}
+
+template<typename K, typename V, typename Compare>
+typename FlatMap<K, V, Compare>::iterator FlatMap<K, V, Compare>::Erase(const_iterator pos) {
+	keys_.Erase(keys_.cbegin() + pos.index_);
+	values_.Erase(values_.cbegin() + pos.index_);
+	return {this, pos.index_};
+}
+
+template<typename K, typename V, typename Compare>
+const Vector<K>& FlatMap<K, V, Compare>::Keys() const noexcept {
+	return keys_;
+}
+
+template<typename K, typename V, typename Compare>
+Vector<V>& FlatMap<K, V, Compare>::Values() noexcept {
+	return values_;
+}
+
+template<typename K, typename V, typename Compare>
+const Vector<V>& FlatMap<K, V, Compare>::Values() const noexcept {
+	return values_;
+}
+
+template<typename K, typename V, typename Compare>
+size_t FlatMap<K, V, Compare>::LowerIndex(const K& key) const {
+	return static_cast<size_t>(flat_map_detail::LowerBound(keys_.Data(), keys_.Size(), key, comp_) - keys_.Data());
+}
+
+template<typename K, typename V, typename Compare>
+bool FlatMap<K, V, Compare>::IsKeyAt(size_t index, const K& key) const {
+	return index < keys_.Size() && !comp_(key, keys_[index]);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg, typename... Args>
+std::pair<typename FlatMap<K, V, Compare>::iterator, bool> FlatMap<K, V, Compare>::EmplaceKey(KeyArg&& key, Args&&... args) {
+	size_t index = LowerIndex(key);
+	if (IsKeyAt(index, key)) {
+		return {iterator{this, index}, false};
+	}
+	values_.Emplace(values_.cbegin() + index, std::forward<Args>(args)...);
+	try {
+		keys_.Emplace(keys_.cbegin() + index, std::forward<KeyArg>(key));
+	}
+	catch (...) {
+		values_.Erase(values_.cbegin() + index);
+		throw;
+	}
+	return {iterator{this, index}, true};
+}
+
+template<typename K, typename V, typename Compare>
+void FlatMap<K, V, Compare>::Merge(Vector<std::pair<K, V>>& entries) {
+	auto key_less = [this](const std::pair<K, V>& lhs, const std::pair<K, V>& rhs) {
+		return comp_(lhs.first, rhs.first);
+	};
+	std::stable_sort(entries.begin(), entries.end(), key_less);
+	auto unique_end = std::unique(entries.begin(), entries.end(), [&key_less](const auto& lhs, const auto& rhs) {
+		return !key_less(lhs, rhs);
+	});
+	entries.Erase(unique_end, entries.end());
+
+	// Where each entry goes, SIZE_MAX if the map has its key already; no comparison runs once elements move
+	Vector<size_t> positions(entries.Size());
+	size_t new_count = 0;
+	for (size_t i = 0; i < entries.Size(); ++i) {
+		size_t index = LowerIndex(entries[i].first);
+		bool present = IsKeyAt(index, entries[i].first);
+		positions[i] = present ? SIZE_MAX : index;
+		new_count += present ? 0 : 1;
+	}
+	if (new_count == 0) {
+		return;
+	}
+
+	// Moving a key and then failing to copy its value would leave a moved-from key behind,
+	// so existing elements are moved only when both moves are noexcept
+	constexpr bool kMoveExisting = std::is_nothrow_move_constructible_v<K> && std::is_nothrow_move_constructible_v<V>;
+	Vector<K> keys;
+	Vector<V> values;
+	keys.Reserve(keys_.Size() + new_count);
+	values.Reserve(keys_.Size() + new_count);
+	size_t index = 0;
+	auto take_existing = [&](size_t end) {
+		for (; index < end; ++index) {
+			if constexpr (kMoveExisting) {
+				keys.EmplaceBackUnchecked(std::move(keys_[index]));
+				values.EmplaceBackUnchecked(std::move(values_[index]));
+			}
+			else {
+				keys.EmplaceBackUnchecked(std::as_const(keys_[index]));
+				values.EmplaceBackUnchecked(std::as_const(values_[index]));
+			}
+		}
+	};
+	for (size_t i = 0; i < entries.Size(); ++i) {
+		if (positions[i] == SIZE_MAX) {
+			continue;
+		}
+		take_existing(positions[i]);
+		keys.EmplaceBackUnchecked(std::move(entries[i].first));
+		values.EmplaceBackUnchecked(std::move(entries[i].second));
+	}
+	take_existing(keys_.Size());
+	keys_.Swap(keys);
+	values_.Swap(values);
+}
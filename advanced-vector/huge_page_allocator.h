@@ -0,0 +1,111 @@
+#pragma once
+
+#include "mmap_memory.h"
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+inline constexpr size_t kHugePageSize = size_t{2} << 20;
+
+enum class HugePageMode {
+	// 2 MiB aligned anonymous mapping with madvise(MADV_HUGEPAGE), backed by transparent huge pages
+	Transparent,
+	// MAP_HUGETLB from the preallocated huge page pool, falling back to Transparent when it is empty
+	Explicit,
+};
+
+// Allocator for very large buffers that are scanned linearly. Blocks from Threshold bytes up are
+// mapped directly, aligned to 2 MiB and backed by huge pages to cut TLB misses; smaller blocks
+// go through operator new. Mapped blocks are released with munmap.
+template<typename T, size_t Threshold = kHugePageSize, HugePageMode Mode = HugePageMode::Transparent>
+class HugePageAllocator {
+	static_assert(alignof(T) <= kHugePageSize);
+
+public:
+	using value_type = T;
+
+	using is_always_equal = std::true_type;
+
+	template<typename U>
+	struct rebind {
+		using other = HugePageAllocator<U, Threshold, Mode>;
+	};
+
+	HugePageAllocator() noexcept = default;
+
+	template<typename U>
+	HugePageAllocator(const HugePageAllocator<U, Threshold, Mode>&) noexcept {}
+
+	T* allocate(size_t n);
+
+	void deallocate(T* buf, size_t n) noexcept;
+
+	friend bool operator==(const HugePageAllocator&, const HugePageAllocator&) noexcept {return true;}
+
+	friend bool operator!=(const HugePageAllocator&, const HugePageAllocator&) noexcept {return false;}
+
+private:
+	static bool IsMapped(size_t bytes) noexcept;
+
+	static size_t MappedSize(size_t bytes) noexcept;
+
+	static void* Map(size_t bytes) noexcept;
+};
+
+template<typename T, size_t Threshold, HugePageMode Mode>
+T* HugePageAllocator<T, Threshold, Mode>::allocate(size_t n) {
+	if (n > (SIZE_MAX - 2 * kHugePageSize) / sizeof(T)) {
+		throw std::bad_array_new_length();
+	}
+	size_t bytes = n * sizeof(T);
+	if (!IsMapped(bytes)) {
+		return static_cast<T*>(operator new(bytes, std::align_val_t{alignof(T)}));
+	}
+	void* buf = Map(MappedSize(bytes));
+	if (buf == nullptr) {
+		throw std::bad_alloc();
+	}
+	return static_cast<T*>(buf);
+}
+
+template<typename T, size_t Threshold, HugePageMode Mode>
+void HugePageAllocator<T, Threshold, Mode>::deallocate(T* buf, size_t n) noexcept {
+	size_t bytes = n * sizeof(T);
+	if (IsMapped(bytes)) {
+		MmapMemory::Unmap(buf, MappedSize(bytes));
+	}
+	else {
+		operator delete(buf, std::align_val_t{alignof(T)});
+	}
+}
+
+template<typename T, size_t Threshold, HugePageMode Mode>
+bool HugePageAllocator<T, Threshold, Mode>::IsMapped(size_t bytes) noexcept {
+	return bytes >= Threshold;
+}
+
+template<typename T, size_t Threshold, HugePageMode Mode>
+size_t HugePageAllocator<T, Threshold, Mode>::MappedSize(size_t bytes) noexcept {
+	return MmapMemory::RoundUp(bytes, kHugePageSize);
+}
+
+template<typename T, size_t Threshold, HugePageMode Mode>
+void* HugePageAllocator<T, Threshold, Mode>::Map(size_t bytes) noexcept {
+#ifdef MAP_HUGETLB
+	if constexpr (Mode == HugePageMode::Explicit) {
+		if (void* buf = MmapMemory::MapAnonymous(bytes, MAP_HUGETLB)) {
+			return buf;
+		}
+	}
+#endif
+	void* buf = MmapMemory::MapAligned(bytes, kHugePageSize);
+#ifdef MADV_HUGEPAGE
+	if (buf != nullptr) {
+		// Only advice: if THP is disabled the mapping still works with regular pages
+		madvise(buf, bytes, MADV_HUGEPAGE);
+	}
+#endif
+	return buf;
+}
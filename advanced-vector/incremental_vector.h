@@ -0,0 +1,435 @@
+#pragma once
+
+#include "vector.h"
+
+// Vector whose growth never moves more than MigrationStep elements in one call. When EmplaceBack
+// runs out of room it allocates the next buffer, constructs the new element there and keeps the
+// old buffer alive; each later EmplaceBack or Step() then migrates the next MigrationStep
+// elements, and the old buffer is freed once it is drained. While a migration is in progress
+// operator[] picks the buffer with one extra comparison. With DoublingGrowth the migration ends
+// long before the new buffer fills up; a growth policy that grows by less than 1/MigrationStep
+// of the size may have to finish a pending migration at once.
+//
+// Elements are not contiguous during a migration, so there is no Data(). Reserve reallocates
+// eagerly and is meant for setup outside the latency-sensitive path. Exception guarantees match
+// Vector: an element that fails to migrate stays in the old buffer and the call has no effect.
+template<typename T, typename Allocator = std::allocator<T>, size_t MigrationStep = 32, typename GrowthPolicy = DoublingGrowth>
+class IncrementalVector {
+	static_assert(MigrationStep > 0, "MigrationStep must move at least one element per call");
+
+	template<bool Const>
+	class Iterator;
+
+public:
+	using value_type = T;
+
+	using allocator_type = Allocator;
+
+	using iterator = Iterator<false>;
+
+	using const_iterator = Iterator<true>;
+
+	IncrementalVector() noexcept(std::is_nothrow_default_constructible_v<Allocator>) = default;
+
+	explicit IncrementalVector(const Allocator& alloc) noexcept;
+
+	IncrementalVector(const IncrementalVector& other);
+
+	IncrementalVector(IncrementalVector&& other) noexcept;
+
+	~IncrementalVector();
+
+	IncrementalVector& operator=(const IncrementalVector& rhs);
+
+	IncrementalVector& operator=(IncrementalVector&& rhs) noexcept;
+
+	iterator begin() noexcept;
+
+	iterator end() noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	void Swap(IncrementalVector& other) noexcept;
+
+	// True while some elements still live in the previous buffer
+	bool IsMigrating() const noexcept;
+
+	// Migrates the next MigrationStep elements, e.g. from an idle loop
+	void Step();
+
+	// Migrates all remaining elements and frees the previous buffer
+	void FinishMigration();
+
+	void Reserve(size_t new_capacity);
+
+	void Clear() noexcept;
+
+	template<typename... Args>
+	T& EmplaceBack(Args&&... args);
+
+	T& PushBack(const T& value);
+
+	T& PushBack(T&& value);
+
+	void PopBack() noexcept;
+
+	const T& operator[](size_t index) const noexcept;
+
+	T& operator[](size_t index) noexcept;
+
+private:
+	// Elements [migrated_, old_size_) are still in old_, all others are in data_ at their own index
+	T* Slot(size_t index) noexcept;
+
+	size_t NextCapacity(size_t required) const noexcept;
+
+	void ReleaseOld() noexcept;
+
+	template<typename... Args>
+	ADVANCED_VECTOR_COLD T& EmplaceWithReallocate(Args&&... args);
+
+	RawMemory<T, Allocator> data_;
+
+	RawMemory<T, Allocator> old_;
+
+	size_t size_ = 0;
+
+	size_t old_size_ = 0;
+
+	size_t migrated_ = 0;
+};
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+template<bool Const>
+class IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Iterator {
+	using Owner = std::conditional_t<Const, const IncrementalVector, IncrementalVector>;
+
+public:
+	using iterator_category = std::random_access_iterator_tag;
+
+	using value_type = T;
+
+	using difference_type = ptrdiff_t;
+
+	using pointer = std::conditional_t<Const, const T*, T*>;
+
+	using reference = std::conditional_t<Const, const T&, T&>;
+
+	Iterator() noexcept = default;
+
+	Iterator(Owner* owner, size_t index) noexcept : owner_(owner), index_(index) {}
+
+	// iterator converts to const_iterator
+	template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+	Iterator(const Iterator<OtherConst>& other) noexcept : owner_(other.owner_), index_(other.index_) {}
+
+	reference operator*() const noexcept {return (*owner_)[index_];}
+
+	pointer operator->() const noexcept {return &(*owner_)[index_];}
+
+	reference operator[](difference_type n) const noexcept {return (*owner_)[index_ + n];}
+
+	Iterator& operator++() noexcept {++index_; return *this;}
+
+	Iterator operator++(int) noexcept {Iterator old = *this; ++index_; return old;}
+
+	Iterator& operator--() noexcept {--index_; return *this;}
+
+	Iterator operator--(int) noexcept {Iterator old = *this; --index_; return old;}
+
+	Iterator& operator+=(difference_type n) noexcept {index_ += n; return *this;}
+
+	Iterator& operator-=(difference_type n) noexcept {index_ -= n; return *this;}
+
+	friend Iterator operator+(Iterator it, difference_type n) noexcept {return it += n;}
+
+	friend Iterator operator+(difference_type n, Iterator it) noexcept {return it += n;}
+
+	friend Iterator operator-(Iterator it, difference_type n) noexcept {return it -= n;}
+
+	friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+		return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+	}
+
+	friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ == rhs.index_;}
+
+	friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ != rhs.index_;}
+
+	friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ < rhs.index_;}
+
+	friend bool operator>(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ > rhs.index_;}
+
+	friend bool operator<=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ <= rhs.index_;}
+
+	friend bool operator>=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ >= rhs.index_;}
+
+private:
+	friend class Iterator<!Const>;
+
+	Owner* owner_ = nullptr;
+
+	size_t index_ = 0;
+};
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::IncrementalVector(const Allocator& alloc) noexcept
+	: data_(alloc), old_(alloc)
+{
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::IncrementalVector(const IncrementalVector& other)
+	: IncrementalVector(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.data_.GetAllocator()))
+{
+	Reserve(other.size_);
+	for (const T& value : other) {
+		new (data_ + size_) T(value);
+		++size_;
+	}
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::IncrementalVector(IncrementalVector&& other) noexcept
+	: data_(std::move(other.data_))
+	, old_(std::move(other.old_))
+	, size_(std::exchange(other.size_, 0))
+	, old_size_(std::exchange(other.old_size_, 0))
+	, migrated_(std::exchange(other.migrated_, 0))
+{
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::~IncrementalVector() {
+	Clear();
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>&
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::operator=(const IncrementalVector& rhs) {
+	if (this != &rhs) {
+		IncrementalVector copy(rhs);
+		Swap(copy);
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>&
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::operator=(IncrementalVector&& rhs) noexcept {
+	if (this != &rhs) {
+		IncrementalVector moved(std::move(rhs));
+		Swap(moved);
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+typename IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::iterator
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::begin() noexcept {
+	return {this, 0};
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+typename IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::iterator
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::end() noexcept {
+	return {this, size_};
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+typename IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::const_iterator
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::begin() const noexcept {
+	return {this, 0};
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+typename IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::const_iterator
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::end() const noexcept {
+	return {this, size_};
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+typename IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::const_iterator
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+typename IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::const_iterator
+IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::cend() const noexcept {
+	return end();
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+size_t IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Size() const noexcept {
+	return size_;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+size_t IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Capacity() const noexcept {
+	return data_.Capacity();
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Swap(IncrementalVector& other) noexcept {
+	data_.Swap(other.data_);
+	old_.Swap(other.old_);
+	std::swap(size_, other.size_);
+	std::swap(old_size_, other.old_size_);
+	std::swap(migrated_, other.migrated_);
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+bool IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::IsMigrating() const noexcept {
+	return migrated_ != old_size_;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Step() {
+	if (!IsMigrating()) {
+		return;
+	}
+	size_t count = std::min(MigrationStep, old_size_ - migrated_);
+	// Relocation is all or nothing, so a throwing copy leaves the elements in the old buffer
+	SafeRelocate(old_ + migrated_, count, data_ + migrated_);
+	migrated_ += count;
+	if (migrated_ == old_size_) {
+		ReleaseOld();
+	}
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::FinishMigration() {
+	if (IsMigrating()) {
+		SafeRelocate(old_ + migrated_, old_size_ - migrated_, data_ + migrated_);
+		ReleaseOld();
+	}
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Reserve(size_t new_capacity) {
+	if (new_capacity <= data_.Capacity()) {
+		return;
+	}
+	FinishMigration();
+	RawMemory<T, Allocator> new_data{new_capacity, data_.GetAllocator()};
+	SafeRelocate(data_.GetAddress(), size_, new_data.GetAddress());
+	data_.Swap(new_data);
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Clear() noexcept {
+	std::destroy_n(data_.GetAddress(), migrated_);
+	std::destroy(old_ + migrated_, old_ + old_size_);
+	std::destroy(data_ + old_size_, data_ + size_);
+	ReleaseOld();
+	size_ = 0;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+template<typename... Args>
+T& IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::EmplaceBack(Args&&... args) {
+	if (ADVANCED_VECTOR_UNLIKELY(size_ == data_.Capacity())) {
+		return EmplaceWithReallocate(std::forward<Args>(args)...);
+	}
+	// args may refer to an element the step is about to move, so the new element comes first
+	T* slot = new (data_ + size_) T(std::forward<Args>(args)...);
+	if (IsMigrating()) {
+		try {
+			Step();
+		}
+		catch (...) {
+			std::destroy_at(slot);
+			throw;
+		}
+	}
+	++size_;
+	return *slot;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+T& IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+T& IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::PopBack() noexcept {
+	assert(size_ > 0);
+	std::destroy_at(Slot(size_ - 1));
+	--size_;
+	if (size_ < old_size_) {
+		// The popped element had not been migrated yet
+		old_size_ = size_;
+		if (migrated_ == old_size_) {
+			ReleaseOld();
+		}
+	}
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+const T& IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::operator[](size_t index) const noexcept {
+	return const_cast<IncrementalVector&>(*this)[index];
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+T& IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return *Slot(index);
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+T* IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::Slot(size_t index) noexcept {
+	// A single unsigned comparison tests migrated_ <= index < old_size_
+	return index - migrated_ < old_size_ - migrated_ ? old_ + index : data_ + index;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+size_t IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::NextCapacity(size_t required) const noexcept {
+	size_t new_capacity = GrowthPolicy::NextCapacity(data_.Capacity(), required, sizeof(T));
+	assert(new_capacity >= required);
+	return new_capacity;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+void IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::ReleaseOld() noexcept {
+	RawMemory<T, Allocator> empty{old_.GetAllocator()};
+	old_.Swap(empty);
+	old_size_ = 0;
+	migrated_ = 0;
+}
+
+template<typename T, typename Allocator, size_t MigrationStep, typename GrowthPolicy>
+template<typename... Args>
+T& IncrementalVector<T, Allocator, MigrationStep, GrowthPolicy>::EmplaceWithReallocate(Args&&... args) {
+	RawMemory<T, Allocator> new_data{NextCapacity(size_ + 1), data_.GetAllocator()};
+	T* slot = new (new_data + size_) T(std::forward<Args>(args)...);
+	try {
+		// Only a growth policy that outpaced the previous migration leaves something to finish
+		FinishMigration();
+	}
+	catch (...) {
+		std::destroy_at(slot);
+		throw;
+	}
+	// The current buffer becomes the one being drained, nothing moves yet
+	old_.Swap(data_);
+	data_.Swap(new_data);
+	old_size_ = size_;
+	migrated_ = 0;
+	++size_;
+	return *slot;
+}
@@ -1,7 +1,30 @@
 #include "vector.h"
-
+#include "small_vector.h"
+#include "realloc_allocator.h"
+#include "huge_page_allocator.h"
+#include "aligned_allocator.h"
+#include "mapped_vector.h"
+#include "vector_io.h"
+#include "parallel.h"
+#include "concurrent_vector.h"
+#include "segmented_vector.h"
+#include "soa_vector.h"
+#include "simd_kernels.h"
+#include "cow_vector.h"
+#include "ring_vector.h"
+#include "flat_map.h"
+#include "pool_allocator.h"
+#include "static_vector.h"
+#include "incremental_vector.h"
+#include "numa_allocator.h"
+
+#include <map>
+#include <deque>
+#include <sstream>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
+#include <memory_resource>
 #include <string>
 
 namespace {
@@ -91,8 +114,109 @@ namespace {
         static inline int num_destroyed = 0;
     };
 
+    struct RelocatableObj {
+
+        RelocatableObj() = default;
+
+        explicit RelocatableObj(int id) : id(id) {}
+
+        RelocatableObj(const RelocatableObj& other) : id(other.id) {++num_copied;}
+
+        RelocatableObj(RelocatableObj&& other) noexcept : id(other.id) {++num_moved;}
+
+        RelocatableObj& operator=(const RelocatableObj& other) = default;
+        RelocatableObj& operator=(RelocatableObj&& other) = default;
+
+        ~RelocatableObj() {++num_destroyed;}
+
+        static void ResetCounters() {
+            num_copied = 0;
+            num_moved = 0;
+            num_destroyed = 0;
+        }
+
+        int id = 0;
+
+        static inline int num_copied = 0;
+        static inline int num_moved = 0;
+        static inline int num_destroyed = 0;
+    };
+
+    // Stateful allocator that counts live allocations per arena id
+    template<typename T>
+    struct CountingAllocator {
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+
+        explicit CountingAllocator(int arena) noexcept : arena(arena) {}
+
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U>& other) noexcept : arena(other.arena) {}
+
+        T* allocate(size_t n) {
+            ++num_allocations;
+            return static_cast<T*>(operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t) noexcept {
+            --num_allocations;
+            operator delete(p);
+        }
+
+        friend bool operator==(const CountingAllocator& lhs, const CountingAllocator& rhs) noexcept {
+            return lhs.arena == rhs.arena;
+        }
+
+        friend bool operator!=(const CountingAllocator& lhs, const CountingAllocator& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+        int arena = 0;
+
+        static inline int num_allocations = 0;
+    };
+
+    // Counts live objects across threads; copying an object with a negative value throws
+    struct Tracked {
+        explicit Tracked(int v = 0) : value(v) {++alive;}
+        Tracked(const Tracked& other) : value(other.value) {
+            if (value < 0) {
+                throw std::runtime_error("copy failed");
+            }
+            ++alive;
+        }
+        Tracked& operator=(const Tracked&) = default;
+        ~Tracked() {--alive;}
+
+        int value;
+
+        static inline std::atomic<int> alive{0};
+    };
+
+    // Move-only type whose move throws for a negative value
+    struct ThrowingMoveOnly {
+        explicit ThrowingMoveOnly(int v = 0) : value(v) {++alive;}
+        ThrowingMoveOnly(const ThrowingMoveOnly&) = delete;
+        ThrowingMoveOnly(ThrowingMoveOnly&& other) : value(other.value) {
+            if (value < 0) {
+                throw std::runtime_error("move failed");
+            }
+            ++alive;
+        }
+        ThrowingMoveOnly& operator=(ThrowingMoveOnly&& other) = default;
+        ~ThrowingMoveOnly() {--alive;}
+
+        int value;
+
+        static inline std::atomic<int> alive{0};
+    };
+
 }//end namespace
 
+template<>
+struct IsTriviallyRelocatable<RelocatableObj> : std::true_type {};
+
 void Test1() {
 
     Obj::ResetCounters();
@@ -471,6 +595,2066 @@ void Test5() {
     }
 }
 
+void Test6() {
+    const size_t SIZE = 1000;
+
+    static_assert(IsTriviallyRelocatableV<int>);
+    static_assert(!IsTriviallyRelocatableV<std::string>);
+    static_assert(!IsTriviallyRelocatableV<Obj>);
+    static_assert(IsTriviallyRelocatableV<RelocatableObj>);
+
+    {
+        Vector<int> v;
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+
+        assert(v.Size() == SIZE);
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+    }
+
+    {
+        RelocatableObj::ResetCounters();
+
+        Vector<RelocatableObj> v;
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+
+        v.Reserve(SIZE * 4);
+        v.Insert(v.begin(), RelocatableObj{-1});
+
+        assert(RelocatableObj::num_copied == 0);
+        assert(RelocatableObj::num_moved == 2);
+        assert(RelocatableObj::num_destroyed == 2);
+        assert(v.Size() == SIZE + 1);
+        assert(v[0].id == -1);
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i + 1].id == static_cast<int>(i));
+        }
+    }
+
+    assert(RelocatableObj::num_destroyed == static_cast<int>(SIZE) + 3);
+}
+
+void Test7() {
+    const size_t SIZE = 100;
+
+    {
+        char buffer[4096];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+        pmr::Vector<int> v{std::pmr::polymorphic_allocator<int>(&arena)};
+        v.Reserve(SIZE);
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+
+        auto* first = reinterpret_cast<char*>(&v[0]);
+        assert(first >= buffer && first < buffer + sizeof(buffer));
+        assert(v.GetAllocator().resource() == &arena);
+
+        pmr::Vector<int> v_moved(std::move(v));
+        assert(v_moved.Size() == SIZE);
+        assert(v_moved.GetAllocator().resource() == &arena);
+    }
+
+    {
+        using Alloc = CountingAllocator<Obj>;
+        Obj::ResetCounters();
+
+        Vector<Obj, Alloc> v1(SIZE, Alloc{1});
+        Vector<Obj, Alloc> v2(SIZE / 2, Alloc{2});
+        v1[0].id = 42;
+
+        assert(Alloc::num_allocations == 2);
+
+        // Different arenas and no propagation: elements are moved, allocators stay put
+        v2 = std::move(v1);
+
+        assert(v2.GetAllocator().arena == 2);
+        assert(v2.Size() == SIZE);
+        assert(v2[0].id == 42);
+        assert(v1.Size() == 0);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+
+        Vector<Obj, Alloc> v3(std::move(v2), Alloc{3});
+        assert(v3.GetAllocator().arena == 3);
+        assert(v3.Size() == SIZE);
+        assert(v3[0].id == 42);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+
+        Vector<Obj, Alloc> v4(Alloc{3});
+        v4 = std::move(v3);
+        assert(v4.Size() == SIZE);
+        assert(v3.Capacity() == 0);
+    }
+
+    assert(CountingAllocator<Obj>::num_allocations == 0);
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test8() {
+    const size_t INLINE = 4;
+    const size_t SIZE = 100;
+    const int ID = 42;
+    using namespace std::literals;
+
+    {
+        SmallVector<std::string, INLINE> v;
+
+        assert(v.Capacity() == INLINE);
+        assert(v.IsInline());
+
+        for (size_t i = 0; i < INLINE; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+
+        auto* first = reinterpret_cast<const char*>(&v[0]);
+        auto* object = reinterpret_cast<const char*>(&v);
+        assert(v.IsInline());
+        assert(first >= object && first < object + sizeof(v));
+
+        v.PushBack("spill"s);
+
+        assert(!v.IsInline());
+        assert(v.Capacity() == INLINE * 2);
+        assert(v.Size() == INLINE + 1);
+        assert(v[0] == "0"s && v[INLINE] == "spill"s);
+
+        v.Insert(v.begin(), "front"s);
+        v.Erase(v.begin() + 1);
+        assert(v[0] == "front"s && v[1] == "1"s);
+
+        SmallVector<std::string, INLINE> v_copy(v);
+        SmallVector<std::string, INLINE> v_small;
+        v_small.PushBack("small"s);
+        v_small.Swap(v_copy);
+
+        assert(v_small.Size() == INLINE + 1 && v_small[0] == "front"s);
+        assert(v_copy.Size() == 1 && v_copy[0] == "small"s && v_copy.IsInline());
+    }
+
+    {
+        Obj::ResetCounters();
+
+        SmallVector<Obj, INLINE> v(INLINE);
+        v[INLINE / 2].id = ID;
+
+        SmallVector<Obj, INLINE> v_moved(std::move(v));
+        assert(v.Size() == 0);
+        assert(v_moved.Size() == INLINE);
+        assert(v_moved[INLINE / 2].id == ID);
+        assert(Obj::num_moved == INLINE);
+        assert(Obj::GetAliveObjectCount() == INLINE);
+
+        v_moved.Resize(SIZE);
+        assert(v_moved.Size() == SIZE);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+
+    {
+        Obj::ResetCounters();
+
+        SmallVector<Obj, INLINE> v(INLINE);
+        v[INLINE - 1].throw_on_copy = true;
+
+        try {
+            SmallVector<Obj, INLINE> v_copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+
+        assert(Obj::GetAliveObjectCount() == INLINE);
+
+        v.EmplaceBack(ID);
+        assert(v.Size() == INLINE + 1);
+        assert(Obj::num_copied == INLINE - 1);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+
+    {
+        // A throwing move past the hole leaves an empty vector instead of destroying elements twice
+        SmallVector<ThrowingMoveOnly, INLINE> v;
+        for (size_t i = 0; i < INLINE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        v[INLINE - 1].value = -1;
+        try {
+            v.Emplace(v.begin() + 1, 42);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 0 && ThrowingMoveOnly::alive == 0);
+        v.EmplaceBack(1);
+        assert(v.Size() == 1 && v[0].value == 1);
+    }
+    assert(ThrowingMoveOnly::alive == 0);
+
+    {
+        SmallVector<int, 2, HalfGrowth> v;
+        for (int i = 0; i < 3; ++i) {
+            v.PushBack(i);
+        }
+        assert(!v.IsInline() && v.Capacity() == HalfGrowth::NextCapacity(2, 3, sizeof(int)));
+    }
+}
+
+void Test9() {
+    const size_t SIZE = 100;
+
+    assert(DoublingGrowth::NextCapacity(0, 1, sizeof(int)) == 1);
+    assert(DoublingGrowth::NextCapacity(8, 9, sizeof(int)) == 16);
+    assert(HalfGrowth::NextCapacity(0, 1, sizeof(int)) == 2);
+    assert(HalfGrowth::NextCapacity(100, 101, sizeof(int)) == 150);
+    assert((MinCapacityGrowth<8>::NextCapacity(0, 1, sizeof(int)) == 8));
+    assert((MinCapacityGrowth<8>::NextCapacity(8, 9, sizeof(int)) == 16));
+    assert(SizeClassGrowth<>::RoundToSizeClass(1) == 16);
+    assert(SizeClassGrowth<>::RoundToSizeClass(100) == 112);
+    assert(SizeClassGrowth<>::RoundToSizeClass(129) == 160);
+    assert(SizeClassGrowth<>::RoundToSizeClass(1000) == 1024);
+    assert(SizeClassGrowth<>::RoundToSizeClass(1025) == 1280);
+    assert(SizeClassGrowth<>::NextCapacity(0, 1, 8) == 2);
+    assert(SizeClassGrowth<>::NextCapacity(100, 101, 8) == 224);
+
+    {
+        Vector<int, std::allocator<int>, MinCapacityGrowth<8>> v;
+
+        v.PushBack(1);
+        assert(v.Capacity() == 8);
+
+        for (size_t i = 1; i < 9; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        assert(v.Capacity() == 16);
+    }
+
+    {
+        Obj::ResetCounters();
+
+        Vector<Obj, std::allocator<Obj>, HalfGrowth> v(SIZE);
+
+        v.Insert(v.begin(), Obj{1});
+        assert(v.Capacity() == SIZE + SIZE / 2);
+        assert(v.Size() == SIZE + 1);
+        assert(v[0].id == 1);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test10() {
+    using namespace std::literals;
+
+    const auto make = [](std::initializer_list<int> values) {
+        Vector<int> v;
+        v.Assign(values.begin(), values.end());
+        return v;
+    };
+    const auto equals = [](const Vector<int>& v, std::initializer_list<int> values) {
+        return v.Size() == values.size() && std::equal(v.begin(), v.end(), values.begin());
+    };
+    const int extra[] = {7, 8, 9};
+
+    {
+        auto v = make({1, 2, 3, 4, 5});
+        v.Reserve(10);
+
+        // Tail longer than the range
+        auto it = v.Insert(v.begin() + 1, std::begin(extra), std::end(extra));
+        assert(it == v.begin() + 1);
+        assert(equals(v, {1, 7, 8, 9, 2, 3, 4, 5}));
+        assert(v.Capacity() == 10);
+    }
+
+    {
+        auto v = make({1, 2, 3, 4, 5});
+        v.Reserve(10);
+
+        // Range longer than the tail
+        v.Insert(v.begin() + 4, std::begin(extra), std::end(extra));
+        assert(equals(v, {1, 2, 3, 4, 7, 8, 9, 5}));
+
+        v.Insert(v.begin(), 2, 0);
+        assert(equals(v, {0, 0, 1, 2, 3, 4, 7, 8, 9, 5}));
+        assert(v.Capacity() == 10);
+
+        // Reallocation, with the value aliasing an element
+        v.Insert(v.begin() + 2, 3, v[9]);
+        assert(equals(v, {0, 0, 5, 5, 5, 1, 2, 3, 4, 7, 8, 9, 5}));
+        assert(v.Capacity() == 20);
+
+        v.Insert(v.begin() + 1, 2, v[9]);
+        assert(equals(v, {0, 7, 7, 0, 5, 5, 5, 1, 2, 3, 4, 7, 8, 9, 5}));
+    }
+
+    {
+        Vector<int> v;
+        v.Append(std::begin(extra), std::end(extra));
+        v.Append(std::begin(extra), std::begin(extra));
+        assert(equals(v, {7, 8, 9}));
+        assert(v.Capacity() == 3);
+
+        std::istringstream in("1 2 3");
+        v.Insert(v.begin() + 1, std::istream_iterator<int>(in), std::istream_iterator<int>());
+        assert(equals(v, {7, 1, 2, 3, 8, 9}));
+
+        v.Assign(2, 4);
+        assert(equals(v, {4, 4}));
+        assert(v.Capacity() == 6);
+
+        v.Assign(10, v[0]);
+        assert(v.Size() == 10 && v.Capacity() == 10 && v[9] == 4);
+    }
+
+    {
+        Vector<std::string> v;
+        v.Assign(3, "abc"s);
+
+        const std::string words[] = {"x"s, "y"s};
+        v.Insert(v.begin() + 1, std::begin(words), std::end(words));
+
+        assert(v.Size() == 5);
+        assert(v[0] == "abc"s && v[1] == "x"s && v[2] == "y"s && v[3] == "abc"s);
+    }
+
+    {
+        Obj::ResetCounters();
+
+        Vector<Obj> v(5);
+        Vector<Obj> source(4);
+        source[3].throw_on_copy = true;
+
+        try {
+            v.Insert(v.begin() + 2, source.begin(), source.end());
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+
+        // The reallocating path gives the strong guarantee
+        assert(v.Size() == 5);
+        assert(v.Capacity() == 5);
+        assert(Obj::GetAliveObjectCount() == 9);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test11() {
+    const size_t SIZE = 1000;
+
+    {
+        Vector<int> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+
+        auto it = v.Erase(v.begin() + 10, v.begin() + 20);
+        assert(it == v.begin() + 10);
+        assert(v.Size() == SIZE - 10);
+        assert(v[9] == 9 && v[10] == 20);
+
+        it = v.Erase(v.begin() + 5, v.begin() + 5);
+        assert(it == v.begin() + 5 && v.Size() == SIZE - 10);
+
+        it = v.Erase(v.end() - 5, v.end());
+        assert(it == v.end());
+
+        const size_t removed = EraseIf(v, [](int x) {return x % 2 == 0;});
+        assert(removed == (SIZE - 15) / 2 + 1);
+        assert(v.Size() == SIZE - 15 - removed);
+        assert(std::all_of(v.begin(), v.end(), [](int x) {return x % 2 == 1;}));
+        assert(std::is_sorted(v.begin(), v.end()));
+    }
+
+    {
+        Obj::ResetCounters();
+
+        Vector<Obj> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+
+        EraseIf(v, [](const Obj& obj) {return obj.id < static_cast<int>(SIZE / 2);});
+
+        assert(v.Size() == SIZE / 2);
+        assert(v[0].id == static_cast<int>(SIZE / 2));
+        assert(Obj::GetAliveObjectCount() == SIZE / 2);
+        assert(v.Capacity() == SIZE);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test12() {
+    const size_t SIZE = 100;
+
+    {
+        Obj::ResetCounters();
+
+        Vector<Obj> v(SIZE, DefaultInit);
+        assert(v.Size() == SIZE && v.Capacity() == SIZE);
+        assert(Obj::num_default_constructed == SIZE);
+
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        assert(Obj::num_default_constructed == SIZE * 2);
+
+        v.ResizeDefaultInit(SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == SIZE / 2);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+
+    {
+        Vector<int> v(SIZE);
+        v[SIZE - 1] = 42;
+
+        v.ResizeUninitialized(SIZE * 4);
+        assert(v.Size() == SIZE * 4 && v.Capacity() == SIZE * 4);
+        assert(v[SIZE - 1] == 42);
+
+        std::fill(v.begin() + SIZE, v.end(), 7);
+        v.ResizeUninitialized(SIZE);
+        assert(v.Size() == SIZE && v.Capacity() == SIZE * 4);
+
+        v.ResizeUninitialized(SIZE + 1);
+        assert(v[SIZE] == 7);
+
+        Vector<int> v_default(SIZE, DefaultInit);
+        v_default[0] = 1;
+        assert(v_default.Size() == SIZE);
+    }
+}
+
+void Test13() {
+    const size_t SIZE = 100;
+
+    {
+        Obj::ResetCounters();
+
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE * 2);
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        v.Resize(SIZE / 2);
+        v[0].id = 42;
+        v.ShrinkToFit();
+        assert(v.Size() == SIZE / 2 && v.Capacity() == SIZE / 2);
+        assert(v[0].id == 42);
+        assert(Obj::num_copied == 0);
+
+        v.ReleaseMemory();
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        assert(v.begin() == nullptr);
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        v.PushBack(Obj{1});
+        assert(v.Size() == 1 && v.Capacity() == 1);
+    }
+
+    {
+        Obj::ResetCounters();
+
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        v[SIZE - 1].throw_on_copy = true;
+
+        try {
+            v.ShrinkToFit();
+        } catch (...) {
+            assert(false && "Unexpected exception");
+        }
+
+        assert(v.Capacity() == SIZE);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+    }
+
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test14() {
+    const size_t SIZE = 100;
+
+#ifndef ADVANCED_VECTOR_ENABLE_STATS
+    // Stateless allocator and disabled statistics add nothing to the layout
+    static_assert(sizeof(Vector<int>) == sizeof(int*) + 2 * sizeof(size_t));
+#endif
+
+    Vector<int> ints;
+    const char* ints_tag = ADVANCED_VECTOR_CALL_SITE;
+    ints.SetStatsTag(ints_tag);
+
+    Vector<Obj> objs(SIZE);
+    objs.SetStatsTag("objs");
+
+    Vector<int, ReallocAllocator<int>> resized;
+    resized.SetStatsTag("resized");
+
+#ifdef ADVANCED_VECTOR_ENABLE_STATS
+    VectorStats::Reset();
+#endif
+
+    for (size_t i = 0; i < SIZE; ++i) {
+        ints.PushBack(static_cast<int>(i));
+        resized.PushBack(static_cast<int>(i));
+    }
+    objs.Reserve(SIZE * 2);
+
+#ifdef ADVANCED_VECTOR_ENABLE_STATS
+    const auto snapshot = VectorStats::Snapshot();
+
+    const auto& ints_stats = snapshot.at(ints_tag);
+    // Capacities 1, 2, 4, ..., 128
+    assert(ints_stats.allocations == 8);
+    assert(ints_stats.reallocations == 7);
+    assert(ints_stats.bytes_moved == (1 + 2 + 4 + 8 + 16 + 32 + 64) * sizeof(int));
+    assert(ints_stats.elements_copied == 0);
+    assert(ints_stats.peak_capacity_bytes == 128 * sizeof(int));
+
+    const auto& objs_stats = snapshot.at("objs");
+    assert(objs_stats.reallocations == 1);
+    assert(objs_stats.bytes_moved == SIZE * sizeof(Obj));
+    assert(objs_stats.peak_capacity_bytes == SIZE * 2 * sizeof(Obj));
+    assert(objs_stats.in_place_reallocations == 0);
+
+    // Only the first buffer is allocated, every growth after it resizes that buffer where it is
+    const auto& resized_stats = snapshot.at("resized");
+    assert(resized_stats.allocations == 1);
+    assert(resized_stats.reallocations == 7 && resized_stats.in_place_reallocations == 7);
+    assert(resized_stats.bytes_moved == 0 && resized_stats.elements_copied == 0);
+    assert(resized_stats.peak_capacity_bytes == 128 * sizeof(int));
+
+    std::ostringstream out;
+    VectorStats::Dump(out);
+    assert(out.str().find("objs: allocations=1 reallocations=1 in_place_reallocations=0") != std::string::npos);
+#endif
+}
+
+void Test15() {
+    // A small threshold sends everything above one page through mmap/mremap
+    using Alloc = ReallocAllocator<int, 4096>;
+    const size_t SIZE = 100'000;
+
+    static_assert(RawMemory<int, Alloc>::kCanReallocate);
+    static_assert(!RawMemory<int>::kCanReallocate);
+
+    {
+        Vector<int, Alloc> v;
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        // The pushed value aliases an element of the buffer that is being resized
+        v.ShrinkToFit();
+        v.PushBack(v[0]);
+
+        assert(v.Size() == SIZE + 1);
+        assert(v[SIZE] == 0);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+
+        v.Reserve(SIZE * 8);
+        assert(v.Capacity() == SIZE * 8);
+        assert(v[SIZE - 1] == static_cast<int>(SIZE - 1));
+
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 10 && v[9] == 9);
+
+        v.Insert(v.end(), 5, v[3]);
+        assert(v.Size() == 15 && v[14] == 3);
+
+        const int extra[] = {1, 2, 3};
+        v.Append(std::begin(extra), std::end(extra));
+        assert(v.Size() == 18 && v[17] == 3);
+    }
+
+    {
+        Vector<std::string, ReallocAllocator<std::string>> v;
+
+        for (size_t i = 0; i < 100; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+
+        assert(v[99] == "99");
+    }
+}
+
+void Test16() {
+    const size_t SMALL_SIZE = 100;
+    const size_t LARGE_SIZE = (kHugePageSize * 2) / sizeof(int);
+
+    {
+        Vector<int, HugePageAllocator<int>> v(SMALL_SIZE);
+        v[SMALL_SIZE - 1] = 1;
+
+        v.Reserve(LARGE_SIZE);
+        assert(reinterpret_cast<uintptr_t>(v.begin()) % kHugePageSize == 0);
+        assert(v[SMALL_SIZE - 1] == 1);
+
+        v.Resize(LARGE_SIZE + 1);
+        assert(reinterpret_cast<uintptr_t>(v.begin()) % kHugePageSize == 0);
+        assert(v[LARGE_SIZE] == 0 && v[SMALL_SIZE - 1] == 1);
+    }
+
+    {
+        Vector<std::string, HugePageAllocator<std::string, kHugePageSize, HugePageMode::Explicit>> v;
+
+        for (size_t i = 0; i < kHugePageSize / sizeof(std::string) + 1; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+
+        assert(reinterpret_cast<uintptr_t>(v.begin()) % kHugePageSize == 0);
+        assert(v[1000] == "1000");
+    }
+}
+
+void Test17() {
+    const size_t SIZE = 1000;
+
+    struct alignas(128) OverAligned {
+        int value = 0;
+    };
+
+    static_assert(Vector<float>::kGuaranteedAlignment == alignof(float));
+    static_assert(Vector<float, AlignedAllocator<float, 64>>::kGuaranteedAlignment == 64);
+    static_assert(Vector<int, CacheAlignedAllocator<int>>::kGuaranteedAlignment == kCacheLineSize);
+
+    {
+        Vector<float, AlignedAllocator<float, 64>> v;
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<float>(i));
+            assert(v.IsAligned(64));
+        }
+
+        v.ShrinkToFit();
+        assert(v.IsAligned(64));
+        assert(v.Data() == &v[0]);
+        assert(v.Data()[SIZE - 1] == static_cast<float>(SIZE - 1));
+    }
+
+    {
+        Vector<double, AlignedAllocator<double, 32>> v(SIZE);
+        const auto v_copy(v);
+
+        assert(v.IsAligned(32) && v_copy.IsAligned(32));
+    }
+
+    {
+        Vector<OverAligned> v;
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack();
+            assert(v.IsAligned(alignof(OverAligned)));
+        }
+    }
+}
+
+void Test18() {
+    const size_t SIZE = 100'000;
+
+    struct Record {
+        int id;
+        double value;
+    };
+
+    const std::string path = "/tmp/advanced_vector_test_" + std::to_string(getpid()) + ".bin";
+    unlink(path.c_str());
+
+    {
+        MappedVector<Record> v(path);
+        assert(v.Size() == 0);
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(Record{static_cast<int>(i), static_cast<double>(i) / 2});
+        }
+        v.PushBack(v[0]);
+        v.PopBack();
+        v.Sync();
+
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() >= SIZE);
+    }
+
+    {
+        MappedVector<Record> v(path);
+
+        assert(v.Size() == SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
+
+        v.Resize(SIZE / 2);
+        v.Flush();
+
+        MappedVector<Record> v_moved(std::move(v));
+        assert(v.Size() == 0);
+        assert(v_moved.Size() == SIZE / 2);
+    }
+
+    {
+        MappedVector<Record> v(path);
+        assert(v.Size() == SIZE / 2);
+        assert(v[SIZE / 2 - 1].value == static_cast<double>(SIZE / 2 - 1) / 2);
+    }
+
+    try {
+        MappedVector<char> wrong_type(path);
+        assert(false && "Exception is expected");
+    } catch (const std::runtime_error&) {
+    }
+
+    unlink(path.c_str());
+}
+
+void Test19() {
+    const size_t SIZE = 100'000;
+
+    struct Point {
+        int x;
+        int y;
+    };
+
+    Vector<Point> v;
+    for (size_t i = 0; i < SIZE; ++i) {
+        v.PushBack(Point{static_cast<int>(i), -static_cast<int>(i)});
+    }
+
+    {
+        std::stringstream stream;
+        WriteTo(stream, v);
+        Vector<Point> loaded(3);
+        ReadFrom(stream, loaded);
+        assert(loaded.Size() == SIZE);
+        assert(loaded[SIZE - 1].x == static_cast<int>(SIZE - 1) && loaded[SIZE - 1].y == -static_cast<int>(SIZE - 1));
+
+        Vector<char> wrong_type;
+        stream.clear();
+        stream.seekg(0);
+        try {
+            ReadFrom(stream, wrong_type);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+    }
+
+    const std::string path = "/tmp/advanced_vector_io_" + std::to_string(getpid()) + ".bin";
+    {
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        assert(fd >= 0);
+        WriteTo(fd, v);
+
+        lseek(fd, 0, SEEK_SET);
+        Vector<Point> loaded;
+        ReadFrom(fd, loaded);
+        assert(loaded.Size() == SIZE);
+        assert(loaded[SIZE / 2].x == static_cast<int>(SIZE / 2));
+
+        lseek(fd, 0, SEEK_SET);
+        ChunkedReader<Point> reader(fd);
+        assert(reader.Remaining() == SIZE);
+        Vector<Point> chunked;
+        chunked.Reserve(SIZE);
+        const Point* data = chunked.Data();
+        size_t chunks = 0;
+        while (reader.ReadChunk(chunked, 4096) != 0) {
+            ++chunks;
+        }
+        assert(chunks == (SIZE + 4095) / 4096);
+        assert(chunked.Size() == SIZE);
+        assert(chunked.Data() == data);
+        assert(chunked[SIZE - 1].y == -static_cast<int>(SIZE - 1));
+
+        // Without a reservation the capacity grows geometrically instead of once per chunk
+        lseek(fd, 0, SEEK_SET);
+        ChunkedReader<Point> unreserved_reader(fd);
+        Vector<Point> unreserved;
+        size_t reallocations = 0;
+        for (const Point* last = unreserved.Data(); unreserved_reader.ReadChunk(unreserved, 100) != 0; last = unreserved.Data()) {
+            reallocations += unreserved.Data() != last ? 1 : 0;
+        }
+        assert(unreserved.Size() == SIZE && reallocations <= 20);
+
+        // A truncated chunk keeps the elements read before the end of input
+        [[maybe_unused]] int rc = ftruncate(fd, sizeof(VectorFileHeader) + sizeof(Point) * 10);
+        lseek(fd, 0, SEEK_SET);
+        ChunkedReader<Point> truncated_reader(fd);
+        Vector<Point> partial;
+        try {
+            truncated_reader.ReadChunk(partial, 100);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(partial.Size() == 10 && partial[9].x == 9 && truncated_reader.Remaining() == 0);
+
+        // A truncated file fails and leaves the destination empty
+        lseek(fd, 0, SEEK_SET);
+        try {
+            ReadFrom(fd, loaded);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(loaded.Size() == 0);
+
+        // A header claiming far more elements than the file holds fails without reserving them
+        VectorFileHeader forged;
+        forged.element_size = sizeof(Point);
+        forged.size = uint64_t{1} << 40;
+        lseek(fd, 0, SEEK_SET);
+        [[maybe_unused]] ssize_t written = write(fd, &forged, sizeof(forged));
+        lseek(fd, 0, SEEK_SET);
+        Vector<Point> target;
+        try {
+            ReadFrom(fd, target);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error& e) {
+            assert(std::string(e.what()).find("unexpected end of input") != std::string::npos);
+        }
+        assert(target.Size() == 0 && target.Capacity() <= 16);
+
+        close(fd);
+    }
+    unlink(path.c_str());
+
+    {
+        // A pipe has no size to check against, so it is read in bounded chunks
+        int fds[2];
+        [[maybe_unused]] int rc = pipe(fds);
+        assert(rc == 0);
+        VectorFileHeader forged;
+        forged.element_size = sizeof(Point);
+        forged.size = uint64_t{1} << 40;
+        const Point points[3] = {{1, 2}, {3, 4}, {5, 6}};
+        [[maybe_unused]] ssize_t written = write(fds[1], &forged, sizeof(forged));
+        written = write(fds[1], points, sizeof(points));
+        close(fds[1]);
+        Vector<Point> loaded;
+        try {
+            ReadFrom(fds[0], loaded);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error& e) {
+            assert(std::string(e.what()).find("unexpected end of input") != std::string::npos);
+        }
+        assert(loaded.Size() == 0 && loaded.Capacity() * sizeof(Point) <= (size_t{1} << 21));
+        close(fds[0]);
+    }
+}
+
+void Test20() {
+    const size_t SIZE = 200'003;
+
+    ThreadPool pool(3);
+    assert(pool.WorkerCount() == 3);
+
+    Vector<int> v(SIZE);
+    ParallelForEach(v, [](int& x) {x += 2;}, pool);
+    assert(std::all_of(v.begin(), v.end(), [](int x) {return x == 2;}));
+
+    Vector<long long> squares;
+    ParallelTransform(v, squares, [](int x) {return static_cast<long long>(x) * x;}, pool);
+    assert(squares.Size() == SIZE);
+    assert(ParallelReduce(squares, 0LL, std::plus<>{}, pool) == 4LL * SIZE);
+
+    // Values in reverse order with duplicates
+    for (size_t i = 0; i < SIZE; ++i) {
+        v[i] = static_cast<int>((SIZE - i) / 3);
+    }
+    ParallelSort(v, std::less<>{}, pool);
+    assert(std::is_sorted(v.begin(), v.end()));
+    assert(v[0] == 0 && v[SIZE - 1] == static_cast<int>(SIZE / 3));
+
+    ParallelSort(v, std::greater<>{}, pool);
+    assert(std::is_sorted(v.begin(), v.end(), std::greater<>{}));
+
+    // Exceptions from any chunk reach the caller after all chunks have finished
+    std::atomic<size_t> visited{0};
+    try {
+        pool.ParallelFor(SIZE, 1000, [&visited](size_t begin, size_t end) {
+            visited += end - begin;
+            if (begin == 5000) {
+                throw std::runtime_error("chunk failed");
+            }
+        });
+        assert(false && "Exception is expected");
+    } catch (const std::runtime_error&) {
+    }
+    assert(visited == SIZE);
+
+    // Nested calls are run by the waiting threads instead of deadlocking
+    std::atomic<size_t> nested{0};
+    pool.ParallelFor(8, 1, [&pool, &nested](size_t, size_t) {
+        pool.ParallelFor(100, 10, [&nested](size_t begin, size_t end) {nested += end - begin;});
+    });
+    assert(nested == 800);
+
+    ThreadPool serial(0);
+    Vector<int> small(100);
+    ParallelForEach(small, [](int& x) {x = 1;}, serial);
+    assert(ParallelReduce(small, 0, std::plus<>{}, serial) == 100);
+}
+
+void Test21() {
+    const size_t SIZE = 50'000;
+
+    ThreadPool pool(3);
+    ThreadPoolBulkExecutor executor(pool);
+    BulkExecution::Enable(executor, 4096);
+    assert(BulkExecution::For(100) == nullptr);
+    assert(BulkExecution::For(4096) == &executor);
+
+    {
+        Vector<int> zeros(SIZE);
+        assert(std::all_of(zeros.begin(), zeros.end(), [](int x) {return x == 0;}));
+
+        Vector<std::string> strings(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            strings[i] = std::to_string(i);
+        }
+        Vector<std::string> copy(strings);
+        assert(copy.Size() == SIZE && copy[SIZE - 1] == std::to_string(SIZE - 1));
+        copy.Reserve(copy.Capacity() * 2);
+        assert(copy[SIZE / 2] == std::to_string(SIZE / 2));
+
+        Vector<std::string> assigned;
+        assigned = strings;
+        assert(assigned[123] == "123");
+    }
+
+    {
+        Vector<Tracked> source(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            source[i].value = static_cast<int>(i);
+        }
+        assert(Tracked::alive == static_cast<int>(SIZE));
+
+        // Only the chunks that were copied completely are destroyed on top of the failing one
+        source[SIZE - 10].value = -1;
+        try {
+            Vector<Tracked> copy(source);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Tracked::alive == static_cast<int>(SIZE));
+
+        // The copy fallback of Reserve leaves the source untouched when a copy throws
+        try {
+            source.Reserve(SIZE * 2);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(source.Size() == SIZE && source[SIZE - 1].value == static_cast<int>(SIZE - 1));
+        assert(Tracked::alive == static_cast<int>(SIZE));
+    }
+    assert(Tracked::alive == 0);
+
+    {
+        Vector<ThrowingMoveOnly> source(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            source[i].value = static_cast<int>(i);
+        }
+        // A throwing move-only type is relocated serially, so a failure leaves every source alive
+        source[SIZE - 10].value = -1;
+        try {
+            source.Reserve(SIZE * 2);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(source.Size() == SIZE && source[SIZE - 1].value == static_cast<int>(SIZE - 1));
+        assert(ThrowingMoveOnly::alive == static_cast<int>(SIZE));
+        source[SIZE - 10].value = 0;
+        source.Reserve(SIZE * 2);
+        assert(source[SIZE - 1].value == static_cast<int>(SIZE - 1));
+    }
+    assert(ThrowingMoveOnly::alive == 0);
+
+    BulkExecution::Disable();
+    assert(BulkExecution::For(SIZE_MAX) == nullptr);
+}
+
+void Test22() {
+    const size_t THREADS = 4;
+    const size_t PER_THREAD = 20'000;
+
+    {
+        ConcurrentVector<std::string> v;
+        std::atomic<bool> done{false};
+        std::atomic<size_t> seen{0};
+
+        // Readers only ever observe fully constructed elements
+        std::thread reader([&] {
+            while (!done.load()) {
+                v.ForEachPublished([&](size_t, const std::string& s) {
+                    assert(s.size() == 16);
+                    (void)s;
+                });
+                seen = v.Size();
+            }
+        });
+
+        Vector<std::thread> writers;
+        for (size_t t = 0; t < THREADS; ++t) {
+            writers.EmplaceBack([&v, t] {
+                for (size_t i = 0; i < PER_THREAD; ++i) {
+                    size_t index = v.EmplaceBack(16, static_cast<char>('a' + t));
+                    assert(v[index][0] == static_cast<char>('a' + t));
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        done = true;
+        reader.join();
+
+        assert(v.Size() == THREADS * PER_THREAD);
+        size_t counts[THREADS] = {};
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v.IsPublished(i));
+            ++counts[v[i][0] - 'a'];
+        }
+        assert(std::all_of(std::begin(counts), std::end(counts), [&](size_t c) {return c == PER_THREAD;}));
+    }
+
+    {
+        // Elements have stable addresses and a failed construction leaves its index unpublished
+        ConcurrentVector<Tracked, 2> v;
+        size_t first = v.EmplaceBack(1);
+        const Tracked* address = &v[first];
+        Tracked bad(-1);
+        try {
+            v.PushBack(bad);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        for (int i = 0; i < 1000; ++i) {
+            v.EmplaceBack(i);
+        }
+        assert(&v[first] == address);
+        assert(!v.IsPublished(1) && v.IsPublished(2) && v[2].value == 0);
+        assert(v.Size() == 1002);
+        assert(Tracked::alive == 1002);
+    }
+    assert(Tracked::alive == 0);
+
+    {
+        // Threads released together race for every new segment, each of which is allocated once
+        ConcurrentVector<size_t, 1> v;
+        std::atomic<bool> go{false};
+        Vector<std::thread> writers;
+        for (size_t t = 0; t < THREADS * 2; ++t) {
+            writers.EmplaceBack([&v, &go, t] {
+                while (!go.load()) {
+                }
+                for (size_t i = 0; i < PER_THREAD / 4; ++i) {
+                    v.PushBack(t);
+                }
+            });
+        }
+        go = true;
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        assert(v.Size() == THREADS * PER_THREAD / 2);
+        size_t counts[THREADS * 2] = {};
+        v.ForEachPublished([&counts](size_t, size_t t) {++counts[t];});
+        assert(std::all_of(std::begin(counts), std::end(counts), [&](size_t c) {return c == PER_THREAD / 4;}));
+    }
+
+    {
+        ConcurrentVector<int> v;
+        v.Reserve(1000);
+        assert(!v.IsPublished(999));
+        v.PushBack(7);
+        assert(v.IsPublished(0) && v[0] == 7);
+    }
+}
+
+void Test23() {
+    const size_t SIZE = 10'000;
+
+    {
+        SegmentedVector<std::string> v;
+        v.PushBack("first");
+        const std::string* first = &v[0];
+        for (size_t i = 1; i < SIZE; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+        // Growth adds segments without moving the existing elements
+        assert(&v[0] == first && *first == "first");
+        const std::string* middle = &v[SIZE / 2];
+        v.Reserve(SIZE * 4);
+        assert(&v[SIZE / 2] == middle);
+        assert(v.Capacity() >= SIZE * 4);
+
+        assert(v.Size() == SIZE);
+        assert(std::distance(v.begin(), v.end()) == static_cast<ptrdiff_t>(SIZE));
+        assert(*(v.begin() + 42) == "42" && v.end()[-1] == std::to_string(SIZE - 1));
+        assert(std::find(v.cbegin(), v.cend(), "777") - v.cbegin() == 777);
+
+        SegmentedVector<std::string> copy = v;
+        assert(copy.Size() == SIZE && copy[SIZE - 1] == v[SIZE - 1]);
+        copy.Resize(10);
+        copy.ShrinkToFit();
+        assert(copy.Size() == 10 && copy.Capacity() < v.Capacity());
+        v = std::move(copy);
+        assert(v.Size() == 10 && copy.Size() == 0);
+    }
+
+    {
+        SegmentedVector<int> v(SIZE);
+        assert(std::all_of(v.begin(), v.end(), [](int x) {return x == 0;}));
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i] = static_cast<int>(SIZE - i);
+        }
+        std::sort(v.begin(), v.end());
+        assert(std::is_sorted(v.begin(), v.end()) && v[0] == 1);
+        v.Clear();
+        assert(v.Size() == 0 && v.Capacity() >= SIZE);
+    }
+
+    {
+        // Elements built before a throwing constructor are destroyed, in the size and copy constructors alike
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = static_cast<int>(SIZE / 2);
+        try {
+            SegmentedVector<Obj> v(SIZE);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        SegmentedVector<Obj> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        v[SIZE / 2].throw_on_copy = true;
+        try {
+            SegmentedVector<Obj> copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    Obj::ResetCounters();
+
+    {
+        SegmentedVector<Tracked> v;
+        for (int i = 0; i < 16; ++i) {
+            v.EmplaceBack(i);
+        }
+        size_t capacity = v.Capacity();
+        assert(capacity == 16);
+        Tracked bad(-1);
+        try {
+            v.PushBack(bad);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 16 && v.Capacity() > capacity);
+        assert(Tracked::alive == 17);
+    }
+    assert(Tracked::alive == 0);
+
+    {
+        // An allocator that does not propagate stays with its vector, so assignment copies or moves elements
+        using Alloc = CountingAllocator<int>;
+        SegmentedVector<int, Alloc> first(100, Alloc(1));
+        SegmentedVector<int, Alloc> second(Alloc(2));
+        first[99] = 7;
+        second = first;
+        assert(second.GetAllocator().arena == 2 && second.Size() == 100 && second[99] == 7);
+        SegmentedVector<int, Alloc> third(Alloc(3));
+        third = std::move(first);
+        assert(third.GetAllocator().arena == 3 && third.Size() == 100 && third[99] == 7);
+        assert(first.Size() == 0 && first.GetAllocator().arena == 1);
+        SegmentedVector<int, Alloc> same(10, Alloc(2));
+        second.Swap(same);
+        assert(second.Size() == 10 && same.Size() == 100 && same.GetAllocator().arena == 2);
+    }
+    assert(CountingAllocator<int>::num_allocations == 0);
+
+    {
+        // NumaAllocator propagates on copy assignment and swap, as it does for Vector
+        using Alloc = NumaAllocator<int>;
+        SegmentedVector<int, Alloc> bound(20, Alloc(NumaPolicy::Bind(0)));
+        SegmentedVector<int, Alloc> plain;
+        plain.PushBack(1);
+        plain = bound;
+        assert(plain.GetAllocator().Policy() == NumaPolicy::Bind(0) && plain.Size() == 20);
+        SegmentedVector<int, Alloc> other(5);
+        other.Swap(plain);
+        assert(other.GetAllocator().Policy() == NumaPolicy::Bind(0) && other.Size() == 20);
+        assert(plain.GetAllocator().Policy() == NumaPolicy::FirstTouch() && plain.Size() == 5);
+    }
+}
+
+void Test24() {
+    const size_t SIZE = 1000;
+
+    {
+        SoAVector<float, float, std::string> particles;
+        for (size_t i = 0; i < SIZE; ++i) {
+            auto row = particles.EmplaceBack(static_cast<float>(i), static_cast<float>(i) * 2, std::to_string(i));
+            assert(row.Get<2>() == std::to_string(i));
+        }
+        assert(particles.Size() == SIZE && particles.Capacity() >= SIZE);
+
+        // Each field is a contiguous column of its own
+        ColumnSpan<float> xs = particles.Column<0>();
+        assert(xs.Size() == SIZE && &xs[1] == xs.Data() + 1);
+        float sum = 0;
+        for (float x : xs) {
+            sum += x;
+        }
+        assert(sum == static_cast<float>(SIZE * (SIZE - 1) / 2));
+
+        auto [x, y, name] = particles[10];
+        assert(x == 10.0f && y == 20.0f && name == "10");
+        y = -1.0f;
+        assert(particles.Column<1>()[10] == -1.0f);
+        particles[11].Tie() = std::make_tuple(0.5f, 0.25f, std::string("eleven"));
+        assert(particles[11].Get<2>() == "eleven");
+
+        // An argument referring to an existing row survives the reallocation it triggers
+        particles.Reserve(particles.Size());
+        while (particles.Size() < particles.Capacity()) {
+            particles.EmplaceBack(0.0f, 0.0f, "");
+        }
+        particles.EmplaceBack(particles[0].Get<0>(), particles[0].Get<1>(), particles[0].Get<2>());
+        assert(particles[particles.Size() - 1].Get<2>() == "0");
+
+        const auto copy = particles;
+        assert(copy.Size() == particles.Size() && copy[SIZE - 1].Get<2>() == std::to_string(SIZE - 1));
+        particles.PopBack();
+        particles.Clear();
+        assert(particles.Size() == 0 && copy.Size() != 0);
+    }
+
+    {
+        // Tracked has a throwing copy and no move constructor, so growth copies that column
+        SoAVector<int, Tracked> v;
+        for (int i = 0; i < 8; ++i) {
+            v.EmplaceBack(i, i);
+        }
+        v.Reserve(8);
+        assert(v.Capacity() == 8);
+        try {
+            v.EmplaceBack(8, Tracked(-1));
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 8 && v.Capacity() == 8);
+
+        v[3].Get<1>().value = -1;
+        try {
+            v.Reserve(100);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 8 && v.Capacity() == 8 && v[7].Get<1>().value == 7);
+        assert(Tracked::alive == 8);
+    }
+    assert(Tracked::alive == 0);
+
+    {
+        // A throwing move-only column is moved before the others relocate, so its failure leaves every row in place
+        SoAVector<std::string, ThrowingMoveOnly> v;
+        v.Reserve(8);
+        for (int i = 0; i < 8; ++i) {
+            v.EmplaceBack(std::to_string(i), i);
+        }
+        v[5].Get<1>().value = -1;
+        try {
+            v.Reserve(100);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 8 && v.Capacity() == 8 && v[7].Get<0>() == "7" && v[0].Get<0>() == "0");
+        assert(ThrowingMoveOnly::alive == 8);
+        v[5].Get<1>().value = 5;
+        v.EmplaceBack("8", 8);
+        assert(v.Size() == 9 && v[5].Get<1>().value == 5 && v[8].Get<0>() == "8");
+    }
+    assert(ThrowingMoveOnly::alive == 0);
+}
+
+template<typename T, typename Allocator>
+void CheckSimdKernels() {
+    const size_t SIZE = 1003;
+
+    Vector<T, Allocator> v(SIZE);
+    simd::Fill(v, T(3));
+    assert(std::all_of(v.begin(), v.end(), [](T x) {return x == T(3);}));
+    assert(simd::Count(v, T(3)) == SIZE);
+    assert(simd::Sum(v) == T(3 * SIZE));
+
+    for (size_t i = 0; i < SIZE; ++i) {
+        v[i] = static_cast<T>(i % 100);
+    }
+    v[700] = T(-5);
+    v[SIZE - 1] = T(1000);
+    assert(simd::MinMax(v) == std::make_pair(T(-5), T(1000)));
+    assert(simd::Count(v, T(7)) == static_cast<size_t>(std::count(v.begin(), v.end(), T(7))));
+    assert(simd::Find(v, T(-5)) == v.begin() + 700);
+    assert(simd::Find(v, T(1000)) == v.begin() + (SIZE - 1));
+    assert(simd::Find(v, T(12345)) == v.end());
+    assert(simd::Find(std::as_const(v), T(99)) == v.begin() + 99);
+
+    Vector<T, Allocator> w(SIZE);
+    simd::Fill(w, T(2));
+    simd::Add(v, w);
+    assert(v[10] == T(12) && v[SIZE - 1] == T(1002));
+    simd::Multiply(v, w);
+    assert(v[10] == T(24) && v[700] == T(-6));
+
+    Vector<T, Allocator> tiny(1);
+    tiny[0] = T(9);
+    assert(simd::MinMax(tiny) == std::make_pair(T(9), T(9)));
+    assert(simd::Sum(Vector<T, Allocator>()) == T(0));
+}
+
+void Test25() {
+    for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse2, simd::Level::Avx2, simd::Level::Avx512}) {
+        simd::SetLevel(level);
+        assert(simd::ActiveLevel() <= simd::SupportedLevel());
+        CheckSimdKernels<int, std::allocator<int>>();
+        CheckSimdKernels<float, std::allocator<float>>();
+        CheckSimdKernels<double, std::allocator<double>>();
+        CheckSimdKernels<int64_t, std::allocator<int64_t>>();
+        CheckSimdKernels<float, CacheAlignedAllocator<float>>();
+        CheckSimdKernels<double, CacheAlignedAllocator<double>>();
+    }
+    simd::SetLevel(simd::SupportedLevel());
+}
+
+void Test26() {
+    const size_t SIZE = 1000;
+
+    {
+        CowVector<std::string> v;
+        assert(v.Size() == 0 && v.UseCount() == 0 && v.begin() == v.end());
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+
+        // Copies share the buffer until one of them is modified
+        CowVector<std::string> snapshot = v;
+        assert(v.UseCount() == 2 && snapshot.Data() == v.Data());
+        const auto& const_v = v;
+        assert(const_v[10] == "10" && v.UseCount() == 2);
+
+        v[10] = "ten";
+        assert(v.UseCount() == 1 && snapshot.UseCount() == 1);
+        assert(snapshot[10] == "10" && v[10] == "ten");
+
+        CowVector<std::string> second = snapshot;
+        second.PushBack(second[0]);
+        assert(second.Size() == SIZE + 1 && second[SIZE] == "0" && snapshot.Size() == SIZE);
+
+        CowVector<std::string> third = snapshot;
+        third.Erase(third.cbegin() + 1, third.cbegin() + 11);
+        assert(third.Size() == SIZE - 10 && third[1] == "11" && snapshot[1] == "1");
+        third.Insert(third.cbegin(), "front");
+        assert(third[0] == "front" && snapshot[0] == "0");
+
+        CowVector<std::string> fourth = snapshot;
+        fourth.Clear();
+        assert(fourth.Size() == 0 && snapshot.Size() == SIZE && snapshot.UseCount() == 1);
+    }
+
+    {
+        // Snapshots handed to other threads stay intact while the owner keeps writing
+        CowVector<int> v(SIZE);
+        Vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            CowVector<int> snapshot = v;
+            readers.EmplaceBack([snapshot, t] {
+                for (int round = 0; round < 100; ++round) {
+                    assert(std::accumulate(snapshot.begin(), snapshot.end(), 0) == t * (t + 1) / 2);
+                    CowVector<int> local = snapshot;
+                    (void)local;
+                }
+            });
+            v[t] = t + 1;
+        }
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        assert(v.UseCount() == 1 && v[3] == 4);
+    }
+}
+
+void Test27() {
+    const size_t SIZE = 8;
+
+    {
+        // Every growing call reads its argument before the elements leave the old buffer
+        Vector<std::string> v;
+        v.PushBack(std::string(32, 'a'));
+        while (v.Size() < v.Capacity()) {
+            v.PushBack(v[v.Size() - 1]);
+        }
+        v.PushBack(v[0]);
+        assert(v[v.Size() - 1] == std::string(32, 'a'));
+        v.ShrinkToFit();
+        v.Emplace(v.cbegin() + 1, v[0].size(), 'b');
+        assert(v[1] == std::string(32, 'b') && v[2] == std::string(32, 'a'));
+        v.ShrinkToFit();
+        v.Insert(v.cbegin(), 2, v[1]);
+        assert(v[0] == v[3] && v[1] == v[3]);
+    }
+
+    {
+        Vector<int, ReallocAllocator<int>> v;
+        v.PushBack(1);
+        for (size_t i = 0; i < SIZE * 1000; ++i) {
+            v.PushBack(v[i]);
+        }
+        assert(std::count(v.begin(), v.end(), 1) == static_cast<long>(v.Size()));
+    }
+
+    {
+        // A throwing element in the grown part leaves the contents and the buffer untouched
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        Obj* data = v.Data();
+        Obj::default_construction_throw_countdown = SIZE / 2;
+        try {
+            v.Resize(SIZE * 2);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE && v.Capacity() == SIZE && v.Data() == data);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+
+        v.Resize(SIZE * 2);
+        assert(v.Size() == SIZE * 2 && v.Capacity() == SIZE * 2);
+        v.ResizeDefaultInit(SIZE * 3);
+        assert(v.Size() == SIZE * 3 && Obj::GetAliveObjectCount() == static_cast<int>(SIZE * 3));
+    }
+    Obj::ResetCounters();
+}
+
+void Test28() {
+    const size_t SIZE = 100;
+
+    {
+        Vector<int> v;
+        v.Reserve(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBackUnchecked(static_cast<int>(i));
+        }
+        assert(v.Size() == SIZE && v.Capacity() == SIZE && v[SIZE - 1] == static_cast<int>(SIZE - 1));
+
+        {
+            auto scope = v.BeginAppend(SIZE);
+            assert(v.Capacity() >= SIZE * 2 && scope.Remaining() == SIZE);
+            for (size_t i = 0; i < SIZE; ++i) {
+                scope.PushBack(v[i]);
+            }
+            assert(scope.Remaining() == 0 && v.Size() == SIZE);
+        }
+        assert(v.Size() == SIZE * 2 && v[SIZE * 2 - 1] == static_cast<int>(SIZE - 1));
+    }
+
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        v.EmplaceBack(1);
+        try {
+            auto scope = v.BeginAppend(SIZE);
+            for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+                scope.EmplaceBack(i);
+                if (i == 10) {
+                    throw std::runtime_error("decode error");
+                }
+            }
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        // The scope rolled back its elements, the old ones are intact
+        assert(v.Size() == 1 && v[0].id == 1 && Obj::GetAliveObjectCount() == 1);
+
+        {
+            // An exception handled inside the scope does not roll it back
+            auto scope = v.BeginAppend(2);
+            scope.EmplaceBack(2);
+            try {
+                throw std::runtime_error("handled");
+            }
+            catch (const std::runtime_error&) {
+            }
+            scope.EmplaceBack(3);
+        }
+        assert(v.Size() == 3 && v[2].id == 3 && Obj::GetAliveObjectCount() == 3);
+    }
+    Obj::ResetCounters();
+}
+
+void Test29() {
+    const int SIZE = 1000;
+
+    {
+        // Used as a queue the ring keeps its buffer and wraps around it
+        RingVector<int> queue;
+        queue.Reserve(16);
+        int next = 0;
+        for (int round = 0; round < SIZE; ++round) {
+            queue.PushBack(next++);
+            queue.PushBack(next++);
+            assert(queue.Front() == next - 1 - static_cast<int>(queue.Size()) + 1);
+            queue.PopFront();
+        }
+        assert(queue.Size() == SIZE && queue.Back() == next - 1);
+        for (int i = 0; i < SIZE; ++i) {
+            assert(queue[i] == SIZE + i);
+        }
+
+        // The two runs cover the elements in order
+        long long sum = 0;
+        for (int value : queue.ArrayOne()) {
+            sum += value;
+        }
+        for (int value : queue.ArrayTwo()) {
+            sum += value;
+        }
+        assert(queue.ArrayOne().Size() + queue.ArrayTwo().Size() == queue.Size());
+        assert(sum == std::accumulate(queue.begin(), queue.end(), 0LL));
+    }
+
+    {
+        RingVector<std::string> ring;
+        std::deque<std::string> expected;
+        for (int i = 0; i < SIZE; ++i) {
+            std::string value(20, static_cast<char>('a' + i % 26));
+            if (i % 3 == 0) {
+                ring.PushFront(value);
+                expected.push_front(value);
+            }
+            else {
+                ring.PushBack(value);
+                expected.push_back(value);
+            }
+            if (i % 7 == 0) {
+                ring.PopBack();
+                expected.pop_back();
+            }
+        }
+        assert(std::equal(ring.begin(), ring.end(), expected.begin(), expected.end()));
+
+        // Growing reads the argument before the elements move
+        ring.ShrinkToFit();
+        ring.PushFront(ring.Back());
+        assert(ring.Front() == expected.back());
+        ring.ShrinkToFit();
+        ring.PushBack(ring.Front());
+        assert(ring.Back() == expected.back());
+
+        RingVector<std::string> copy = ring;
+        assert(std::equal(copy.begin(), copy.end(), ring.begin(), ring.end()));
+        copy.Clear();
+        assert(copy.Size() == 0 && ring.Size() == expected.size() + 2);
+        copy = std::move(ring);
+        assert(ring.Size() == 0 && copy.Size() == expected.size() + 2);
+    }
+
+    {
+        // A throwing copy during growth leaves the ring unchanged
+        Obj::ResetCounters();
+        RingVector<Obj> ring;
+        ring.EmplaceBack(1);
+        ring.EmplaceFront(2);
+        Obj thrower(3);
+        thrower.throw_on_copy = true;
+        try {
+            ring.PushBack(thrower);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(ring.Size() == 2 && ring[0].id == 2 && ring[1].id == 1);
+        ring.PopFront();
+        ring.PopFront();
+        assert(ring.Size() == 0 && Obj::GetAliveObjectCount() == 1);
+    }
+    Obj::ResetCounters();
+}
+
+void Test30() {
+    const int SIZE = 1000;
+
+    {
+        // Built from unsorted keys with duplicates by one sort and dedup
+        Vector<int> keys;
+        for (int i = 0; i < SIZE; ++i) {
+            keys.PushBack((i * 7919) % (SIZE / 2));
+        }
+        FlatSet<int> set(keys.begin(), keys.end());
+        assert(set.Size() == SIZE / 2 && std::is_sorted(set.begin(), set.end()));
+        for (int i = 0; i < SIZE / 2; ++i) {
+            assert(set.Contains(i) && *set.Find(i) == i && *set.LowerBound(i) == i);
+        }
+        assert(!set.Contains(-1) && set.Find(SIZE) == set.end() && set.UpperBound(SIZE / 2 - 1) == set.end());
+
+        assert(!set.Insert(5).second);
+        assert(*set.Insert(SIZE).first == SIZE && set.Size() == SIZE / 2 + 1);
+        assert(set.Erase(SIZE) == 1 && set.Erase(SIZE) == 0);
+
+        // Range insert merges in one pass and keeps the keys unique
+        Vector<int> more;
+        for (int i = SIZE; i > 0; --i) {
+            more.PushBack(i);
+        }
+        set.Insert(more.begin(), more.end());
+        assert(set.Size() == SIZE + 1 && std::adjacent_find(set.begin(), set.end()) == set.end());
+        assert(*set.begin() == 0 && *(set.end() - 1) == SIZE);
+    }
+
+    {
+        // A comparator throwing in the middle of a range insert leaves the set as it was
+        struct CountdownLess {
+            int* budget;
+            bool operator()(int lhs, int rhs) const {
+                if (*budget > 0 && --*budget == 0) {
+                    throw std::runtime_error("compare failed");
+                }
+                return lhs < rhs;
+            }
+        };
+        int budget = 0;
+        FlatSet<int, CountdownLess> set(CountdownLess{&budget});
+        for (int i = 0; i < SIZE; i += 2) {
+            set.Insert(i);
+        }
+        Vector<int> before(set.Keys());
+        Vector<int> more;
+        for (int i = SIZE; i > 0; --i) {
+            more.PushBack(i);
+        }
+        for (int limit : {5, 500, 5000, 11000}) {
+            budget = limit;
+            try {
+                set.Insert(more.begin(), more.end());
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(std::equal(set.begin(), set.end(), before.begin(), before.end()));
+        }
+        budget = 0;
+        set.Insert(more.begin(), more.end());
+        assert(set.Size() == SIZE + 1 && set.Contains(SIZE - 1));
+    }
+
+    {
+        std::map<std::string, int> expected;
+        Vector<std::pair<std::string, int>> entries;
+        for (int i = 0; i < SIZE; ++i) {
+            std::string key = "route" + std::to_string((i * 31) % 300);
+            entries.PushBack({key, i});
+            expected.insert({key, i});
+        }
+        FlatMap<std::string, int> map(entries.begin(), entries.end());
+        assert(map.Size() == expected.size());
+        assert(std::equal(map.begin(), map.end(), expected.begin(), expected.end(), [](auto lhs, const auto& rhs) {
+            return lhs.first == rhs.first && lhs.second == rhs.second;
+        }));
+
+        for (auto [key, value] : map) {
+            value += 1;
+        }
+        assert(map.At("route0") == expected["route0"] + 1);
+        try {
+            map.At("missing");
+            assert(false);
+        }
+        catch (const std::out_of_range&) {
+        }
+
+        assert(!map.Emplace("route0", -1).second && map["route0"] == expected["route0"] + 1);
+        auto [it, inserted] = map.Emplace("new", 42);
+        assert(inserted && it.Key() == "new" && it.Value() == 42);
+        assert(!map.InsertOrAssign("new", 43).second && map.At("new") == 43);
+        map["other"] += 5;
+        assert(map.At("other") == 5 && map.Size() == expected.size() + 2);
+        assert(map.Erase("new") == 1 && map.Erase("other") == 1 && !map.Contains("new"));
+
+        // Existing keys win over the merged range
+        const std::pair<std::string, int> update[] = {{"route0", -1}, {"zzz", 1}, {"aaa", 2}, {"aaa", 3}};
+        map.Insert(std::begin(update), std::end(update));
+        assert(map.Size() == expected.size() + 2 && map.At("route0") == expected["route0"] + 1);
+        assert(map.At("aaa") == 2 && (*map.begin()).first == "aaa" && (*(map.end() - 1)).first == "zzz");
+        assert(std::is_sorted(map.Keys().begin(), map.Keys().end()) && map.Values().Size() == map.Size());
+    }
+
+    {
+        // A comparator throwing in the middle of a merge leaves the map as it was
+        struct CountdownLess {
+            int* budget;
+            bool operator()(const std::string& lhs, const std::string& rhs) const {
+                if (*budget > 0 && --*budget == 0) {
+                    throw std::runtime_error("compare failed");
+                }
+                return lhs < rhs;
+            }
+        };
+        int budget = 0;
+        FlatMap<std::string, int, CountdownLess> map(CountdownLess{&budget});
+        for (int i = 0; i < 20; ++i) {
+            map.Emplace("key" + std::to_string(i * 2), i);
+        }
+        Vector<std::pair<std::string, int>> more;
+        for (int i = 0; i < 40; ++i) {
+            more.PushBack({"key" + std::to_string(i), -i});
+        }
+        Vector<std::string> keys_before(map.Keys());
+        Vector<int> values_before(map.Values());
+        // Every comparison of the merge fails once, until the budget outlasts them all
+        for (int limit = 1;; ++limit) {
+            budget = limit;
+            try {
+                map.Insert(more.begin(), more.end());
+                break;
+            } catch (const std::runtime_error&) {
+            }
+            assert(std::equal(map.Keys().begin(), map.Keys().end(), keys_before.begin(), keys_before.end()));
+            assert(std::equal(map.Values().begin(), map.Values().end(), values_before.begin(), values_before.end()));
+        }
+        budget = 0;
+        assert(map.Size() == 40 && map.At("key2") == 1 && map.At("key3") == -3);
+    }
+
+    {
+        // Values that may throw on copy are copied together with their keys, so a failing copy
+        // cannot leave a moved-from key behind
+        FlatMap<std::string, Tracked> map;
+        for (int i = 0; i < 10; ++i) {
+            map.Emplace(std::string(20, static_cast<char>('a' + i * 2)), i);
+        }
+        const std::string third(20, 'g');
+        map.At(third).value = -1;
+        const std::pair<std::string, Tracked> more[] = {{"b", Tracked(1)}, {"l", Tracked(11)}};
+        try {
+            map.Insert(std::begin(more), std::end(more));
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(map.Size() == 10 && map.Values().Size() == 10 && map.At(third).value == -1);
+        for (int i = 0; i < 10; ++i) {
+            assert(map.Keys()[i] == std::string(20, static_cast<char>('a' + i * 2)));
+        }
+        map.At(third).value = 3;
+        map.Insert(std::begin(more), std::end(more));
+        assert(map.Size() == 12 && map.At("l").value == 11 && map.At(third).value == 3);
+    }
+    assert(Tracked::alive == 0);
+}
+
+void Test31() {
+    const size_t SIZE = 1000;
+
+    ThreadBufferPool* pool = ThreadBufferPool::Local();
+    assert(pool != nullptr && pool == ThreadBufferPool::Local());
+    pool->Trim();
+    size_t misses = pool->Misses();
+
+    {
+        // Short-lived vectors of similar sizes reuse the buffers of their predecessors
+        for (size_t round = 0; round < SIZE; ++round) {
+            Vector<int, PoolAllocator<int>> v;
+            for (int i = 0; i < 100; ++i) {
+                v.PushBack(i);
+            }
+            assert(v[99] == 99);
+        }
+        assert(pool->Misses() - misses <= 8 && pool->Hits() >= SIZE);
+        assert(pool->CachedBytes() > 0 && pool->CachedBytes() <= pool->MaxCachedBytes());
+
+        pool->Trim();
+        assert(pool->CachedBytes() == 0);
+    }
+
+    {
+        // Capacity fills the whole size class
+        Vector<char, PoolAllocator<char>, PoolClassGrowth<>> v;
+        v.PushBack('a');
+        assert(v.Capacity() == size_t{1} << ThreadBufferPool::kMinClassShift);
+
+        // Large and uncached buffers go straight to operator delete
+        Vector<char, PoolAllocator<char>> big(ThreadBufferPool::kMaxClassBytes + 1);
+        pool->SetMaxCachedBytes(0);
+        {
+            Vector<int, PoolAllocator<int>> v2(SIZE);
+        }
+        assert(pool->CachedBytes() == 0);
+        pool->SetMaxCachedBytes(ThreadBufferPool::kDefaultMaxCachedBytes);
+    }
+
+    {
+        // A buffer freed by another thread joins that thread's cache and is freed when it exits
+        auto* v = new Vector<int, PoolAllocator<int>>(SIZE);
+        size_t cached = pool->CachedBytes();
+        std::thread other([v] {
+            delete v;
+            assert(ThreadBufferPool::Local()->CachedBytes() >= SIZE * sizeof(int));
+        });
+        other.join();
+        assert(pool->CachedBytes() == cached);
+    }
+}
+
+constexpr StaticVector<int, 32> MakePrimes() {
+    StaticVector<int, 32> primes;
+    for (int n = 2; !primes.Full(); ++n) {
+        bool prime = true;
+        for (int p : primes) {
+            prime = prime && n % p != 0;
+        }
+        if (prime) {
+            primes.PushBack(n);
+        }
+    }
+    return primes;
+}
+
+#if __cplusplus >= 202002L
+// Vector allocates during constant evaluation as long as the buffer is freed before it ends
+constexpr int SumOfSquaresAfterGrowth(int count) {
+    Vector<int> v;
+    for (int i = 0; i < count; ++i) {
+        v.PushBack(i * i);
+    }
+    Vector<int> copy = v;
+    copy.Erase(copy.begin());
+    copy.Resize(copy.Size() + 2);
+    copy.Reserve(copy.Capacity() * 2);
+    Vector<int> moved = std::move(copy);
+    moved.PopBack();
+    v = moved;
+    int sum = 0;
+    for (int x : v) {
+        sum += x;
+    }
+    return sum + static_cast<int>(v.Size());
+}
+
+struct ConstexprString {
+    constexpr explicit ConstexprString(int length) : chars(static_cast<size_t>(length)) {}
+
+    Vector<char> chars;
+};
+
+constexpr size_t NestedLength() {
+    Vector<ConstexprString> strings;
+    for (int i = 1; i <= 10; ++i) {
+        strings.EmplaceBack(i);
+    }
+    strings.Erase(strings.begin() + 2, strings.begin() + 4);
+    size_t length = 0;
+    for (const ConstexprString& s : strings) {
+        length += s.chars.Size();
+    }
+    return length;
+}
+#endif
+
+void Test32() {
+#if __cplusplus >= 202002L
+    {
+        // Under C++20 the basic Vector paths run at compile time
+        static_assert(SumOfSquaresAfterGrowth(20) == 2470 + 20);
+        static_assert(NestedLength() == 55 - 3 - 4);
+        assert(SumOfSquaresAfterGrowth(20) == 2470 + 20 && NestedLength() == 48);
+    }
+#endif
+
+    {
+        // Tables of trivial types are built at compile time
+        constexpr StaticVector<int, 32> primes = MakePrimes();
+        static_assert(primes.Size() == 32 && primes[0] == 2 && primes[31] == 131);
+        static_assert(std::is_trivially_copyable_v<StaticVector<int, 32>>);
+        static_assert(DoublingGrowth::NextCapacity(4, 5, sizeof(int)) == 8);
+
+        StaticVector<int, 32> copy = primes;
+        copy.Erase(copy.begin());
+        copy.PopBack();
+        assert(copy.Size() == 30 && copy[0] == 3 && copy[29] == 127);
+        copy.Resize(2);
+        assert(copy.Size() == 2 && copy.Data()[1] == 5);
+    }
+
+    {
+        Obj::ResetCounters();
+        {
+            StaticVector<Obj, 8> v(3);
+            v.EmplaceBack(7);
+            v.EmplaceBack(8, "eight");
+            assert(v.Size() == 5 && v[3].id == 7 && v[4].name == "eight");
+
+            StaticVector<Obj, 8> copy = v;
+            StaticVector<Obj, 8> moved = std::move(copy);
+            assert(moved.Size() == 5 && moved[4].id == 8);
+            moved.Erase(moved.cbegin() + 3);
+            assert(moved.Size() == 4 && moved[3].id == 8);
+            copy = moved;
+            v = std::move(moved);
+            assert(copy.Size() == 4 && v.Size() == 4 && v[3].id == 8 && copy[2].id == 0);
+
+            v.Resize(8);
+            try {
+                v.EmplaceBack(9);
+                assert(false);
+            }
+            catch (const std::length_error&) {
+            }
+            assert(v.Size() == 8 && v.Full());
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        Obj::ResetCounters();
+    }
+}
+
+void Test33() {
+    const int SIZE = 10000;
+    const size_t STEP = 16;
+
+    {
+        // No PushBack moves more than STEP old elements
+        Obj::ResetCounters();
+        {
+            IncrementalVector<Obj, std::allocator<Obj>, STEP> v;
+            int max_moves = 0;
+            bool migrated = false;
+            for (int i = 0; i < SIZE; ++i) {
+                int moved = Obj::num_moved;
+                v.EmplaceBack(i);
+                max_moves = std::max(max_moves, Obj::num_moved - moved);
+                migrated = migrated || v.IsMigrating();
+            }
+            assert(migrated && max_moves <= static_cast<int>(STEP));
+            for (int i = 0; i < SIZE; ++i) {
+                assert(v[i].id == i);
+            }
+            assert(Obj::GetAliveObjectCount() == SIZE);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        Obj::ResetCounters();
+    }
+
+    {
+        IncrementalVector<std::string, std::allocator<std::string>, STEP> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+        while (!v.IsMigrating()) {
+            v.PushBack(v[0]);
+        }
+        // Arguments referring to an element that is about to migrate stay valid
+        size_t size = v.Size();
+        v.PushBack(v[v.Size() / 2 - 1]);
+        v.PushBack(v[1]);
+        assert(v[size] == v[size / 2 - 1] && v[size + 1] == "1");
+
+        IncrementalVector<std::string, std::allocator<std::string>, STEP> copy = v;
+        assert(!copy.IsMigrating() && std::equal(copy.begin(), copy.end(), v.begin(), v.end()));
+
+        // Popping elements that were not migrated yet shortens the migration
+        while (v.IsMigrating() && v.Size() > 0) {
+            v.PopBack();
+        }
+        assert(std::equal(v.begin(), v.end(), copy.begin()));
+
+        copy.PushBack("x");
+        while (!copy.IsMigrating()) {
+            copy.PushBack("x");
+        }
+        copy.Step();
+        copy.FinishMigration();
+        assert(!copy.IsMigrating() && copy[0] == "0" && copy[copy.Size() - 1] == "x");
+        v = std::move(copy);
+        assert(v[1] == "1" && copy.Size() == 0);
+    }
+}
+
+void Test34() {
+    const size_t SIZE = size_t{1} << 20;
+    using Alloc = NumaAllocator<int>;
+
+    uint64_t nodes = numa::OnlineNodes();
+    assert(nodes != 0 && numa::NodeCount() >= 1);
+    unsigned first_node = 0;
+    while ((nodes >> first_node & 1) == 0) {
+        ++first_node;
+    }
+
+    {
+        // Bound pages land on the node, or keep the default placement where binding is unsupported
+        Vector<int, Alloc> v(SIZE, Alloc(NumaPolicy::Bind(first_node)));
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i] = static_cast<int>(i);
+        }
+        int node = numa::NodeOf(v.Data() + SIZE / 2);
+        assert(node == -1 || (nodes >> node & 1) != 0);
+        assert(v.GetAllocator().Policy() == NumaPolicy::Bind(first_node));
+
+        // The policy follows the buffer
+        Vector<int, Alloc> copy = v;
+        assert(copy.GetAllocator() == v.GetAllocator() && copy[SIZE - 1] == static_cast<int>(SIZE - 1));
+        Vector<int, Alloc> interleaved(SIZE, Alloc(NumaPolicy::Interleave(nodes)));
+        assert(interleaved.GetAllocator() != v.GetAllocator() && interleaved[SIZE / 2] == 0);
+        interleaved = std::move(v);
+        assert(interleaved.GetAllocator().Policy() == NumaPolicy::Bind(first_node) && interleaved[7] == 7);
+
+        // Small blocks come from operator new
+        Vector<int, Alloc> small(16, Alloc(NumaPolicy::Interleave(nodes)));
+        small.PushBack(1);
+        assert(small.Size() == 17 && small[16] == 1);
+    }
+
+    {
+        // Each pool thread touches its own chunk of pages, and values survive the touch
+        ThreadPool pool(3);
+        ThreadPoolBulkExecutor executor(pool);
+        Vector<int, Alloc> v;
+        v.ResizeDefaultInit(SIZE);
+        numa::FirstTouch(v.Data(), SIZE * sizeof(int), executor);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i] = static_cast<int>(i * 3);
+        }
+        numa::FirstTouch(v.Data() + 1, 12345 * sizeof(int), executor);
+        numa::FirstTouch(v.Data(), 0, executor);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i * 3));
+        }
+
+        // Parallel value construction places the pages the same way
+        BulkExecution::Enable(executor, 4096);
+        Vector<double, NumaAllocator<double>> values(SIZE);
+        BulkExecution::Disable();
+        assert(values.Size() == SIZE && values[0] == 0.0 && values[SIZE - 1] == 0.0);
+    }
+}
+
 int main() {
     try {
         Test1();
@@ -478,6 +2662,35 @@ int main() {
         Test3();
         Test4();
         Test5();
+        Test6();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
 
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
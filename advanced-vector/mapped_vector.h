@@ -0,0 +1,446 @@
+#pragma once
+
+#include "vector.h"
+#include "mmap_memory.h"
+
+#include <cerrno>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// Memory-mapped file holding a small header followed by capacity elements. Plays the part
+// of RawMemory for MappedVector: storage outlives the process and is reopened without copying.
+template<typename T>
+class FileMemory {
+	static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can live in a mapped file");
+
+public:
+	// Header is padded to a cache line so that elements stay aligned
+	static constexpr size_t kHeaderSize = 64;
+
+	static_assert(alignof(T) <= kHeaderSize);
+
+	FileMemory() noexcept = default;
+
+	// Opens path, creating an empty file when it does not exist
+	explicit FileMemory(const std::string& path);
+
+	FileMemory(const FileMemory&) = delete;
+
+	FileMemory(FileMemory&& other) noexcept;
+
+	~FileMemory();
+
+	FileMemory& operator=(const FileMemory&) = delete;
+
+	FileMemory& operator=(FileMemory&& rhs) noexcept;
+
+	T* GetAddress() noexcept;
+
+	const T* GetAddress() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	// Element count persisted in the header
+	size_t StoredSize() const noexcept;
+
+	void SetStoredSize(size_t size) noexcept;
+
+	// Extends the file with ftruncate and remaps it, keeping the contents
+	void Grow(size_t new_capacity);
+
+	// msync of the whole mapping; blocking when wait is true
+	void Sync(bool wait);
+
+private:
+	struct Header {
+		uint64_t magic;
+		uint64_t element_size;
+		uint64_t size;
+	};
+
+	static constexpr uint64_t kMagic = 0x5645435f4d415050;  // "VEC_MAPP"
+
+	static_assert(sizeof(Header) <= kHeaderSize);
+
+	Header* GetHeader() const noexcept;
+
+	void Map(size_t bytes);
+
+	void Close() noexcept;
+
+	[[noreturn]] static void ThrowErrno(const char* what);
+
+	int fd_ = -1;
+
+	char* mapping_ = nullptr;
+
+	size_t mapped_bytes_ = 0;
+};
+
+template<typename T>
+FileMemory<T>::FileMemory(const std::string& path) {
+	fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd_ < 0) {
+		ThrowErrno("open");
+	}
+	try {
+		struct stat st{};
+		if (fstat(fd_, &st) != 0) {
+			ThrowErrno("fstat");
+		}
+		auto file_size = static_cast<size_t>(st.st_size);
+		if (file_size == 0) {
+			file_size = kHeaderSize;
+			if (ftruncate(fd_, static_cast<off_t>(file_size)) != 0) {
+				ThrowErrno("ftruncate");
+			}
+			Map(file_size);
+			*GetHeader() = Header{kMagic, sizeof(T), 0};
+			return;
+		}
+		if (file_size < kHeaderSize) {
+			throw std::runtime_error("MappedVector: " + path + " is truncated");
+		}
+		Map(file_size);
+		const Header& header = *GetHeader();
+		if (header.magic != kMagic || header.element_size != sizeof(T) || header.size > Capacity()) {
+			throw std::runtime_error("MappedVector: " + path + " has an incompatible header");
+		}
+	}
+	catch (...) {
+		Close();
+		throw;
+	}
+}
+
+template<typename T>
+FileMemory<T>::FileMemory(FileMemory&& other) noexcept
+	: fd_(std::exchange(other.fd_, -1))
+	, mapping_(std::exchange(other.mapping_, nullptr))
+	, mapped_bytes_(std::exchange(other.mapped_bytes_, 0))
+{
+}
+
+template<typename T>
+FileMemory<T>::~FileMemory() {
+	Close();
+}
+
+template<typename T>
+FileMemory<T>& FileMemory<T>::operator=(FileMemory&& rhs) noexcept {
+	if (this != &rhs) {
+		Close();
+		fd_ = std::exchange(rhs.fd_, -1);
+		mapping_ = std::exchange(rhs.mapping_, nullptr);
+		mapped_bytes_ = std::exchange(rhs.mapped_bytes_, 0);
+	}
+	return *this;
+}
+
+template<typename T>
+T* FileMemory<T>::GetAddress() noexcept {
+	return mapping_ != nullptr ? reinterpret_cast<T*>(mapping_ + kHeaderSize) : nullptr;
+}
+
+template<typename T>
+const T* FileMemory<T>::GetAddress() const noexcept {
+	return const_cast<FileMemory&>(*this).GetAddress();
+}
+
+template<typename T>
+size_t FileMemory<T>::Capacity() const noexcept {
+	return mapped_bytes_ > kHeaderSize ? (mapped_bytes_ - kHeaderSize) / sizeof(T) : 0;
+}
+
+template<typename T>
+size_t FileMemory<T>::StoredSize() const noexcept {
+	return mapping_ != nullptr ? static_cast<size_t>(GetHeader()->size) : 0;
+}
+
+template<typename T>
+void FileMemory<T>::SetStoredSize(size_t size) noexcept {
+	assert(size <= Capacity());
+	if (mapping_ != nullptr) {
+		GetHeader()->size = size;
+	}
+}
+
+template<typename T>
+void FileMemory<T>::Grow(size_t new_capacity) {
+	assert(fd_ >= 0);
+	if (new_capacity <= Capacity()) {
+		return;
+	}
+	size_t new_bytes = kHeaderSize + new_capacity * sizeof(T);
+	if (ftruncate(fd_, static_cast<off_t>(new_bytes)) != 0) {
+		ThrowErrno("ftruncate");
+	}
+#ifdef __linux__
+	void* address = mremap(mapping_, mapped_bytes_, new_bytes, MREMAP_MAYMOVE);
+	if (address == MAP_FAILED) {
+		ThrowErrno("mremap");
+	}
+	mapping_ = static_cast<char*>(address);
+	mapped_bytes_ = new_bytes;
+#else
+	// The file already holds the data, so a fresh mapping of the larger file sees it
+	munmap(mapping_, mapped_bytes_);
+	mapping_ = nullptr;
+	Map(new_bytes);
+#endif
+}
+
+template<typename T>
+void FileMemory<T>::Sync(bool wait) {
+	if (mapping_ != nullptr && msync(mapping_, mapped_bytes_, wait ? MS_SYNC : MS_ASYNC) != 0) {
+		ThrowErrno("msync");
+	}
+}
+
+template<typename T>
+typename FileMemory<T>::Header* FileMemory<T>::GetHeader() const noexcept {
+	return reinterpret_cast<Header*>(mapping_);
+}
+
+template<typename T>
+void FileMemory<T>::Map(size_t bytes) {
+	void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+	if (address == MAP_FAILED) {
+		ThrowErrno("mmap");
+	}
+	mapping_ = static_cast<char*>(address);
+	mapped_bytes_ = bytes;
+}
+
+template<typename T>
+void FileMemory<T>::Close() noexcept {
+	if (mapping_ != nullptr) {
+		munmap(mapping_, mapped_bytes_);
+		mapping_ = nullptr;
+		mapped_bytes_ = 0;
+	}
+	if (fd_ >= 0) {
+		close(fd_);
+		fd_ = -1;
+	}
+}
+
+template<typename T>
+void FileMemory<T>::ThrowErrno(const char* what) {
+	throw std::system_error(errno, std::generic_category(), std::string("MappedVector: ") + what);
+}
+
+// Vector of trivially copyable elements stored in a memory-mapped file. Opening an existing file
+// maps it as is, so loading costs one mmap regardless of the size. Changes reach the file through
+// the page cache; Sync() waits for them to hit the disk, Flush() only schedules the write-back.
+template<typename T, typename GrowthPolicy = DoublingGrowth>
+class MappedVector {
+public:
+	using value_type = T;
+
+	using iterator = T*;
+
+	using const_iterator = const T*;
+
+	MappedVector() noexcept = default;
+
+	explicit MappedVector(const std::string& path);
+
+	MappedVector(MappedVector&& other) noexcept;
+
+	MappedVector& operator=(MappedVector&& rhs) noexcept;
+
+	iterator begin() noexcept;
+
+	iterator end() noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	T* Data() noexcept;
+
+	const T* Data() const noexcept;
+
+	void Reserve(size_t new_capacity);
+
+	void Resize(size_t new_size);
+
+	void Clear() noexcept;
+
+	template<typename... Args>
+	T& EmplaceBack(Args &&... args);
+
+	T& PushBack(const T& value);
+
+	void PopBack() noexcept;
+
+	void Sync();
+
+	void Flush();
+
+	const T& operator[](size_t index) const noexcept;
+	T& operator[](size_t index) noexcept;
+
+private:
+	FileMemory<T> data_;
+
+	size_t size_ = 0;
+
+	void SetSize(size_t size) noexcept;
+};
+
+template<typename T, typename GrowthPolicy>
+MappedVector<T, GrowthPolicy>::MappedVector(const std::string& path)
+	: data_(path), size_(data_.StoredSize())
+{
+}
+
+template<typename T, typename GrowthPolicy>
+MappedVector<T, GrowthPolicy>::MappedVector(MappedVector&& other) noexcept
+	: data_(std::move(other.data_)), size_(std::exchange(other.size_, 0))
+{
+}
+
+template<typename T, typename GrowthPolicy>
+MappedVector<T, GrowthPolicy>& MappedVector<T, GrowthPolicy>::operator=(MappedVector&& rhs) noexcept {
+	data_ = std::move(rhs.data_);
+	size_ = std::exchange(rhs.size_, 0);
+	return *this;
+}
+
+template<typename T, typename GrowthPolicy>
+typename MappedVector<T, GrowthPolicy>::iterator MappedVector<T, GrowthPolicy>::begin() noexcept {
+	return data_.GetAddress();
+}
+
+template<typename T, typename GrowthPolicy>
+typename MappedVector<T, GrowthPolicy>::iterator MappedVector<T, GrowthPolicy>::end() noexcept {
+	return data_.GetAddress() + size_;
+}
+
+template<typename T, typename GrowthPolicy>
+typename MappedVector<T, GrowthPolicy>::const_iterator MappedVector<T, GrowthPolicy>::begin() const noexcept {
+	return data_.GetAddress();
+}
+
+template<typename T, typename GrowthPolicy>
+typename MappedVector<T, GrowthPolicy>::const_iterator MappedVector<T, GrowthPolicy>::end() const noexcept {
+	return data_.GetAddress() + size_;
+}
+
+template<typename T, typename GrowthPolicy>
+typename MappedVector<T, GrowthPolicy>::const_iterator MappedVector<T, GrowthPolicy>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename T, typename GrowthPolicy>
+typename MappedVector<T, GrowthPolicy>::const_iterator MappedVector<T, GrowthPolicy>::cend() const noexcept {
+	return end();
+}
+
+template<typename T, typename GrowthPolicy>
+size_t MappedVector<T, GrowthPolicy>::Size() const noexcept {
+	return size_;
+}
+
+template<typename T, typename GrowthPolicy>
+size_t MappedVector<T, GrowthPolicy>::Capacity() const noexcept {
+	return data_.Capacity();
+}
+
+template<typename T, typename GrowthPolicy>
+T* MappedVector<T, GrowthPolicy>::Data() noexcept {
+	return data_.GetAddress();
+}
+
+template<typename T, typename GrowthPolicy>
+const T* MappedVector<T, GrowthPolicy>::Data() const noexcept {
+	return data_.GetAddress();
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::Reserve(size_t new_capacity) {
+	data_.Grow(new_capacity);
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::Resize(size_t new_size) {
+	if (new_size > size_) {
+		Reserve(new_size);
+		std::uninitialized_value_construct_n(data_.GetAddress() + size_, new_size - size_);
+	}
+	SetSize(new_size);
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::Clear() noexcept {
+	SetSize(0);
+}
+
+template<typename T, typename GrowthPolicy>
+template<typename... Args>
+T& MappedVector<T, GrowthPolicy>::EmplaceBack(Args &&... args) {
+	if (size_ == Capacity()) {
+		// args may refer into the mapping, which can move on growth
+		T value(std::forward<Args>(args)...);
+		Reserve(GrowthPolicy::NextCapacity(Capacity(), size_ + 1, sizeof(T)));
+		new (data_.GetAddress() + size_) T(value);
+	}
+	else {
+		new (data_.GetAddress() + size_) T(std::forward<Args>(args)...);
+	}
+	SetSize(size_ + 1);
+	return data_.GetAddress()[size_ - 1];
+}
+
+template<typename T, typename GrowthPolicy>
+T& MappedVector<T, GrowthPolicy>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::PopBack() noexcept {
+	assert(size_ > 0);
+	SetSize(size_ - 1);
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::Sync() {
+	data_.Sync(true);
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::Flush() {
+	data_.Sync(false);
+}
+
+template<typename T, typename GrowthPolicy>
+const T& MappedVector<T, GrowthPolicy>::operator[](size_t index) const noexcept {
+	return const_cast<MappedVector&>(*this)[index];
+}
+
+template<typename T, typename GrowthPolicy>
+T& MappedVector<T, GrowthPolicy>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return data_.GetAddress()[index];
+}
+
+template<typename T, typename GrowthPolicy>
+void MappedVector<T, GrowthPolicy>::SetSize(size_t size) noexcept {
+	size_ = size;
+	data_.SetStoredSize(size);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Thin wrappers over anonymous mmap shared by the mmap-backed allocators.
+// All sizes are in bytes; functions report failure with nullptr instead of throwing.
+struct MmapMemory {
+	static size_t PageSize() noexcept;
+
+	static size_t RoundUp(size_t bytes, size_t alignment) noexcept;
+
+	static void* MapAnonymous(size_t bytes, int extra_flags = 0) noexcept;
+
+	// Maps bytes (a multiple of the page size) at an address aligned to alignment (a power of two
+	// multiple of the page size) by over-mapping and trimming the excess
+	static void* MapAligned(size_t bytes, size_t alignment) noexcept;
+
+	static void Unmap(void* address, size_t bytes) noexcept;
+
+	// Resizes a mapping, moving it if needed. The kernel moves the pages, the contents are not copied
+	static void* Remap(void* address, size_t old_bytes, size_t new_bytes) noexcept;
+};
+
+inline size_t MmapMemory::PageSize() noexcept {
+	static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return page_size;
+}
+
+inline size_t MmapMemory::RoundUp(size_t bytes, size_t alignment) noexcept {
+	return (bytes + alignment - 1) / alignment * alignment;
+}
+
+inline void* MmapMemory::MapAnonymous(size_t bytes, int extra_flags) noexcept {
+	void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+	return address != MAP_FAILED ? address : nullptr;
+}
+
+inline void* MmapMemory::MapAligned(size_t bytes, size_t alignment) noexcept {
+	if (alignment <= PageSize()) {
+		return MapAnonymous(bytes);
+	}
+	auto* raw = static_cast<char*>(MapAnonymous(bytes + alignment));
+	if (raw == nullptr) {
+		return nullptr;
+	}
+	auto address = reinterpret_cast<uintptr_t>(raw);
+	auto* aligned = raw + (RoundUp(address, alignment) - address);
+	size_t head = static_cast<size_t>(aligned - raw);
+	if (head != 0) {
+		munmap(raw, head);
+	}
+	size_t tail = alignment - head;
+	if (tail != 0) {
+		munmap(aligned + bytes, tail);
+	}
+	return aligned;
+}
+
+inline void MmapMemory::Unmap(void* address, size_t bytes) noexcept {
+	if (address != nullptr) {
+		munmap(address, bytes);
+	}
+}
+
+inline void* MmapMemory::Remap(void* address, size_t old_bytes, size_t new_bytes) noexcept {
+#ifdef __linux__
+	void* result = mremap(address, old_bytes, new_bytes, MREMAP_MAYMOVE);
+	return result != MAP_FAILED ? result : nullptr;
+#else
+	void* result = MapAnonymous(new_bytes);
+	if (result != nullptr) {
+		std::memcpy(result, address, old_bytes < new_bytes ? old_bytes : new_bytes);
+		Unmap(address, old_bytes);
+	}
+	return result;
+#endif
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "vector.h"
+#include "mmap_memory.h"
+
+#include <new>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+enum class NumaMode {
+	// Pages land on the node of the thread that first writes them, the kernel default
+	FirstTouch,
+	// Pages are allocated only on the given nodes
+	Bind,
+	// Pages are spread round-robin over the given nodes
+	Interleave,
+	// Pages go to the given node while it has free memory, elsewhere otherwise
+	Preferred,
+};
+
+// Where the pages of a NumaAllocator buffer are placed. Nodes are a bit mask, so node ids from
+// 64 up cannot be named
+struct NumaPolicy {
+	NumaMode mode = NumaMode::FirstTouch;
+
+	uint64_t nodes = 0;
+
+	static NumaPolicy FirstTouch() noexcept {return {};}
+
+	static NumaPolicy Bind(unsigned node) noexcept {return {NumaMode::Bind, uint64_t{1} << node};}
+
+	static NumaPolicy Interleave(uint64_t nodes) noexcept {return {NumaMode::Interleave, nodes};}
+
+	static NumaPolicy Preferred(unsigned node) noexcept {return {NumaMode::Preferred, uint64_t{1} << node};}
+
+	friend bool operator==(const NumaPolicy& lhs, const NumaPolicy& rhs) noexcept {
+		return lhs.mode == rhs.mode && lhs.nodes == rhs.nodes;
+	}
+
+	friend bool operator!=(const NumaPolicy& lhs, const NumaPolicy& rhs) noexcept {return !(lhs == rhs);}
+};
+
+// Placement is best effort and works without libnuma: the policy is applied with the mbind system
+// call, and where the kernel has no NUMA support or refuses the policy the pages keep the default
+// first-touch placement. Contents are never affected
+namespace numa {
+
+	// Mask of the online nodes, bit 0 alone on machines without NUMA
+	uint64_t OnlineNodes() noexcept;
+
+	size_t NodeCount() noexcept;
+
+	// Applies policy to the pages of [address, address + bytes); address is page aligned.
+	// Pages already touched stay where they are. Returns false if the policy was not applied
+	bool Apply(void* address, size_t bytes, const NumaPolicy& policy) noexcept;
+
+	// Node holding the page of address, -1 if it is unknown or the page was never touched
+	int NodeOf(const void* address) noexcept;
+
+	// Touches the pages of [data, data + bytes) in page-aligned chunks run by executor, so with an
+	// executor over the threads that will scan the buffer each of them gets its chunk on its own
+	// node. The bytes keep their values; no other thread may write them meanwhile
+	void FirstTouch(void* data, size_t bytes, BulkExecutor& executor);
+
+}//end namespace numa
+
+inline constexpr size_t kNumaThreshold = size_t{1} << 20;
+
+// Allocator placing every block from Threshold bytes up according to its NumaPolicy. Such blocks
+// are mapped directly and the policy is applied before any page is touched; smaller blocks go
+// through operator new with the default placement. The policy is part of the allocator state and
+// follows a Vector on copy, move and swap.
+//
+// With the FirstTouch policy the pages go to the threads constructing the elements, which
+// combines with the parallel bulk loops of Vector: after EnableParallelBulkOperations, Vector(size)
+// and Resize of at least the threshold construct chunk by chunk on the pool threads. A buffer
+// filled later by other threads can be placed up front with numa::FirstTouch after
+// ResizeDefaultInit.
+template<typename T, size_t Threshold = kNumaThreshold>
+class NumaAllocator {
+	static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "NumaAllocator does not over-align buffers");
+
+public:
+	using value_type = T;
+
+	using propagate_on_container_copy_assignment = std::true_type;
+
+	using propagate_on_container_move_assignment = std::true_type;
+
+	using propagate_on_container_swap = std::true_type;
+
+	using is_always_equal = std::false_type;
+
+	template<typename U>
+	struct rebind {
+		using other = NumaAllocator<U, Threshold>;
+	};
+
+	NumaAllocator() noexcept = default;
+
+	explicit NumaAllocator(const NumaPolicy& policy) noexcept;
+
+	template<typename U>
+	NumaAllocator(const NumaAllocator<U, Threshold>& other) noexcept;
+
+	T* allocate(size_t n);
+
+	void deallocate(T* buf, size_t n) noexcept;
+
+	const NumaPolicy& Policy() const noexcept;
+
+	friend bool operator==(const NumaAllocator& lhs, const NumaAllocator& rhs) noexcept {return lhs.policy_ == rhs.policy_;}
+
+	friend bool operator!=(const NumaAllocator& lhs, const NumaAllocator& rhs) noexcept {return !(lhs == rhs);}
+
+private:
+	static bool IsMapped(size_t bytes) noexcept;
+
+	NumaPolicy policy_;
+};
+
+namespace numa_detail {
+
+#ifdef __linux__
+	// Values of the kernel ABI, so <numaif.h> is not needed
+	inline constexpr int kMpolDefault = 0;
+
+	inline constexpr int kMpolPreferred = 1;
+
+	inline constexpr int kMpolBind = 2;
+
+	inline constexpr int kMpolInterleave = 3;
+
+	inline constexpr unsigned long kMpolFNode = 1;
+
+	inline constexpr unsigned long kMpolFAddr = 2;
+
+	// The kernel reads one bit less than maxnode says
+	inline constexpr unsigned long kMaxNode = 64 + 1;
+
+	inline int KernelMode(NumaMode mode) noexcept {
+		switch (mode) {
+			case NumaMode::Bind:
+				return kMpolBind;
+			case NumaMode::Interleave:
+				return kMpolInterleave;
+			case NumaMode::Preferred:
+				return kMpolPreferred;
+			default:
+				return kMpolDefault;
+		}
+	}
+#endif
+
+	// Parses a node list such as "0-1,4" from sysfs
+	inline uint64_t ReadNodeList(const char* path) noexcept {
+		std::FILE* file = std::fopen(path, "r");
+		if (file == nullptr) {
+			return 1;
+		}
+		uint64_t nodes = 0;
+		unsigned first = 0;
+		while (std::fscanf(file, "%u", &first) == 1) {
+			unsigned last = first;
+			int separator = std::fgetc(file);
+			if (separator == '-' && std::fscanf(file, "%u", &last) == 1) {
+				separator = std::fgetc(file);
+			}
+			for (unsigned node = first; node <= last && node < 64; ++node) {
+				nodes |= uint64_t{1} << node;
+			}
+			if (separator != ',') {
+				break;
+			}
+		}
+		std::fclose(file);
+		return nodes != 0 ? nodes : 1;
+	}
+
+}//end namespace numa_detail
+
+inline uint64_t numa::OnlineNodes() noexcept {
+	static const uint64_t nodes = numa_detail::ReadNodeList("/sys/devices/system/node/online");
+	return nodes;
+}
+
+inline size_t numa::NodeCount() noexcept {
+	size_t count = 0;
+	for (uint64_t nodes = OnlineNodes(); nodes != 0; nodes &= nodes - 1) {
+		++count;
+	}
+	return count;
+}
+
+inline bool numa::Apply(void* address, size_t bytes, const NumaPolicy& policy) noexcept {
+#ifdef __linux__
+	unsigned long mask = policy.mode == NumaMode::FirstTouch ? 0 : static_cast<unsigned long>(policy.nodes & OnlineNodes());
+	if (policy.mode != NumaMode::FirstTouch && mask == 0) {
+		return false;
+	}
+	int mode = numa_detail::KernelMode(policy.mode);
+	unsigned long max_node = mode == numa_detail::kMpolDefault ? 0 : numa_detail::kMaxNode;
+	return syscall(SYS_mbind, address, bytes, mode, mode == numa_detail::kMpolDefault ? nullptr : &mask, max_node, 0) == 0;
+#else
+	(void)address;
+	(void)bytes;
+	return policy.mode == NumaMode::FirstTouch;
+#endif
+}
+
+inline int numa::NodeOf(const void* address) noexcept {
+#ifdef __linux__
+	int node = -1;
+	if (syscall(SYS_get_mempolicy, &node, nullptr, 0, address, numa_detail::kMpolFNode | numa_detail::kMpolFAddr) != 0) {
+		return -1;
+	}
+	return node;
+#else
+	(void)address;
+	return -1;
+#endif
+}
+
+inline void numa::FirstTouch(void* data, size_t bytes, BulkExecutor& executor) {
+	if (bytes == 0) {
+		return;
+	}
+	size_t page_size = MmapMemory::PageSize();
+	auto* first = static_cast<char*>(data);
+	// Chunks start on page boundaries so no page is shared by two threads
+	auto* base = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(first) / page_size * page_size);
+	size_t pages = MmapMemory::RoundUp(static_cast<size_t>(first + bytes - base), page_size) / page_size;
+	struct Context {
+		char* first;
+		char* last;
+		char* base;
+		size_t page_size;
+	} context{first, first + bytes, base, page_size};
+	auto touch = [](void* raw, size_t begin, size_t end) {
+		auto& ctx = *static_cast<Context*>(raw);
+		for (size_t page = begin; page < end; ++page) {
+			char* byte = ctx.base + page * ctx.page_size;
+			volatile char* target = byte < ctx.first ? ctx.first : byte;
+			if (target < ctx.last) {
+				// A write faults the page in here; reading alone would map the shared zero page
+				*target = *target;
+			}
+		}
+	};
+	executor.Run(pages, executor.Grain(pages, page_size), &context, touch);
+}
+
+template<typename T, size_t Threshold>
+NumaAllocator<T, Threshold>::NumaAllocator(const NumaPolicy& policy) noexcept
+	: policy_(policy) {
+}
+
+template<typename T, size_t Threshold>
+template<typename U>
+NumaAllocator<T, Threshold>::NumaAllocator(const NumaAllocator<U, Threshold>& other) noexcept
+	: policy_(other.Policy()) {
+}
+
+template<typename T, size_t Threshold>
+T* NumaAllocator<T, Threshold>::allocate(size_t n) {
+	if (n > (SIZE_MAX - MmapMemory::PageSize()) / sizeof(T)) {
+		throw std::bad_array_new_length();
+	}
+	size_t bytes = n * sizeof(T);
+	if (!IsMapped(bytes)) {
+		return static_cast<T*>(operator new(bytes));
+	}
+	void* buf = MmapMemory::MapAnonymous(MmapMemory::RoundUp(bytes, MmapMemory::PageSize()));
+	if (buf == nullptr) {
+		throw std::bad_alloc();
+	}
+	if (policy_.mode != NumaMode::FirstTouch) {
+		numa::Apply(buf, MmapMemory::RoundUp(bytes, MmapMemory::PageSize()), policy_);
+	}
+	return static_cast<T*>(buf);
+}
+
+template<typename T, size_t Threshold>
+void NumaAllocator<T, Threshold>::deallocate(T* buf, size_t n) noexcept {
+	size_t bytes = n * sizeof(T);
+	if (IsMapped(bytes)) {
+		MmapMemory::Unmap(buf, MmapMemory::RoundUp(bytes, MmapMemory::PageSize()));
+	}
+	else {
+		operator delete(buf);
+	}
+}
+
+template<typename T, size_t Threshold>
+const NumaPolicy& NumaAllocator<T, Threshold>::Policy() const noexcept {
+	return policy_;
+}
+
+template<typename T, size_t Threshold>
+bool NumaAllocator<T, Threshold>::IsMapped(size_t bytes) noexcept {
+	return bytes >= Threshold;
+}
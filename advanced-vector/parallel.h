@@ -0,0 +1,168 @@
+#pragma once
+
+#include "vector.h"
+#include "aligned_allocator.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+
+// Parallel algorithms over the contiguous storage of a Vector. The elements are split into
+// chunks whose size in bytes is a multiple of the cache line, so no two chunks write to the same
+// line (with an allocator aligned to kCacheLineSize the boundaries are exact line boundaries).
+// Vectors shorter than kParallelMinSize, and pools without workers, are processed serially.
+
+inline constexpr size_t kParallelMinSize = size_t{1} << 14;
+
+// Calls f(element) for every element
+template<typename T, typename Allocator, typename GrowthPolicy, typename F>
+void ParallelForEach(Vector<T, Allocator, GrowthPolicy>& vector, F f, ThreadPool& pool = ThreadPool::Default());
+
+// Stores f(input[i]) into output[i]; output is resized to the size of input first
+template<typename T, typename A1, typename G1, typename U, typename A2, typename G2, typename F>
+void ParallelTransform(const Vector<T, A1, G1>& input, Vector<U, A2, G2>& output, F f,
+                       ThreadPool& pool = ThreadPool::Default());
+
+// Folds the elements with op, which must be associative: chunks are reduced independently
+// and the partial results are combined in order, starting from init
+template<typename T, typename Allocator, typename GrowthPolicy, typename R, typename Op = std::plus<>>
+R ParallelReduce(const Vector<T, Allocator, GrowthPolicy>& vector, R init, Op op = {},
+                 ThreadPool& pool = ThreadPool::Default());
+
+// Sorts chunks in parallel, then merges adjacent runs pairwise. Not stable
+template<typename T, typename Allocator, typename GrowthPolicy, typename Compare = std::less<>>
+void ParallelSort(Vector<T, Allocator, GrowthPolicy>& vector, Compare comp = {},
+                  ThreadPool& pool = ThreadPool::Default());
+
+// Runs the bulk loops of Vector (see BulkExecution) on a thread pool
+class ThreadPoolBulkExecutor : public BulkExecutor {
+public:
+	explicit ThreadPoolBulkExecutor(ThreadPool& pool) noexcept;
+
+	size_t Grain(size_t count, size_t element_size) const noexcept override;
+
+	void Run(size_t count, size_t grain, void* context, ChunkFunction fn) override;
+
+private:
+	ThreadPool& pool_;
+};
+
+inline constexpr size_t kDefaultBulkThreshold = size_t{64} << 20;
+
+// Splits Vector loops over at least threshold_bytes across ThreadPool::Default(). Vectors that
+// outlive the default pool, such as globals, must not be destroyed while this is enabled
+void EnableParallelBulkOperations(size_t threshold_bytes = kDefaultBulkThreshold);
+
+namespace parallel_detail {
+
+	// Number of elements per chunk: about four chunks per thread for stealing to even out the
+	// load, rounded up to a whole number of cache lines
+	inline size_t ChunkSize(size_t size, size_t element_size, const ThreadPool& pool, size_t min_chunk) noexcept {
+		size_t line_elements = kCacheLineSize / std::gcd(kCacheLineSize, element_size);
+		size_t chunks = (pool.WorkerCount() + 1) * 4;
+		size_t chunk = std::max((size + chunks - 1) / chunks, min_chunk);
+		return (chunk + line_elements - 1) / line_elements * line_elements;
+	}
+
+	template<typename T>
+	size_t ChunkSize(size_t size, const ThreadPool& pool) noexcept {
+		return ChunkSize(size, sizeof(T), pool, kParallelMinSize / 4);
+	}
+
+	inline bool RunSerially(size_t size, const ThreadPool& pool) noexcept {
+		return size < kParallelMinSize || pool.WorkerCount() == 0;
+	}
+
+}//end namespace parallel_detail
+
+template<typename T, typename Allocator, typename GrowthPolicy, typename F>
+void ParallelForEach(Vector<T, Allocator, GrowthPolicy>& vector, F f, ThreadPool& pool) {
+	T* data = vector.Data();
+	size_t size = vector.Size();
+	if (parallel_detail::RunSerially(size, pool)) {
+		std::for_each(data, data + size, f);
+		return;
+	}
+	pool.ParallelFor(size, parallel_detail::ChunkSize<T>(size, pool), [data, &f](size_t begin, size_t end) {
+		std::for_each(data + begin, data + end, f);
+	});
+}
+
+template<typename T, typename A1, typename G1, typename U, typename A2, typename G2, typename F>
+void ParallelTransform(const Vector<T, A1, G1>& input, Vector<U, A2, G2>& output, F f, ThreadPool& pool) {
+	output.Resize(input.Size());
+	const T* in = input.Data();
+	U* out = output.Data();
+	size_t size = input.Size();
+	if (parallel_detail::RunSerially(size, pool)) {
+		std::transform(in, in + size, out, f);
+		return;
+	}
+	// Chunks are sized by the output, which is the side being written
+	pool.ParallelFor(size, parallel_detail::ChunkSize<U>(size, pool), [in, out, &f](size_t begin, size_t end) {
+		std::transform(in + begin, in + end, out + begin, f);
+	});
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy, typename R, typename Op>
+R ParallelReduce(const Vector<T, Allocator, GrowthPolicy>& vector, R init, Op op, ThreadPool& pool) {
+	const T* data = vector.Data();
+	size_t size = vector.Size();
+	if (parallel_detail::RunSerially(size, pool)) {
+		return std::accumulate(data, data + size, std::move(init), op);
+	}
+	size_t chunk = parallel_detail::ChunkSize<T>(size, pool);
+	Vector<std::optional<R>> partial((size + chunk - 1) / chunk);
+	pool.ParallelFor(size, chunk, [data, chunk, &partial, &op](size_t begin, size_t end) {
+		R acc(data[begin]);
+		for (size_t i = begin + 1; i < end; ++i) {
+			acc = op(std::move(acc), data[i]);
+		}
+		partial[begin / chunk].emplace(std::move(acc));
+	});
+	for (std::optional<R>& value : partial) {
+		init = op(std::move(init), std::move(*value));
+	}
+	return init;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy, typename Compare>
+void ParallelSort(Vector<T, Allocator, GrowthPolicy>& vector, Compare comp, ThreadPool& pool) {
+	T* data = vector.Data();
+	size_t size = vector.Size();
+	if (parallel_detail::RunSerially(size, pool)) {
+		std::sort(data, data + size, comp);
+		return;
+	}
+	size_t chunk = parallel_detail::ChunkSize<T>(size, pool);
+	pool.ParallelFor(size, chunk, [data, &comp](size_t begin, size_t end) {
+		std::sort(data + begin, data + end, comp);
+	});
+	// Each round merges pairs of sorted runs of length run into runs of length 2 * run
+	for (size_t run = chunk; run < size; run *= 2) {
+		pool.ParallelFor(size, 2 * run, [data, run, &comp](size_t begin, size_t end) {
+			if (begin + run < end) {
+				std::inplace_merge(data + begin, data + begin + run, data + end, comp);
+			}
+		});
+	}
+}
+
+inline ThreadPoolBulkExecutor::ThreadPoolBulkExecutor(ThreadPool& pool) noexcept
+	: pool_(pool)
+{
+}
+
+inline size_t ThreadPoolBulkExecutor::Grain(size_t count, size_t element_size) const noexcept {
+	return parallel_detail::ChunkSize(count, element_size, pool_, 1);
+}
+
+inline void ThreadPoolBulkExecutor::Run(size_t count, size_t grain, void* context, ChunkFunction fn) {
+	pool_.ParallelFor(count, grain, [context, fn](size_t begin, size_t end) {fn(context, begin, end);});
+}
+
+inline void EnableParallelBulkOperations(size_t threshold_bytes) {
+	static ThreadPoolBulkExecutor executor(ThreadPool::Default());
+	BulkExecution::Enable(executor, threshold_bytes);
+}
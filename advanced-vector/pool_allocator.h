@@ -0,0 +1,244 @@
+#pragma once
+
+#include "vector.h"
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Per-thread cache of freed buffers bucketed by power-of-two size classes from 64 bytes to
+// kMaxClassBytes. A released buffer goes onto the free list of its class unless the thread
+// already caches max_cached_bytes; an allocation takes the head of the list before falling back
+// to operator new. Buffers above the largest class bypass the cache. A buffer may be released by
+// a different thread than the one that allocated it and then joins that thread's cache.
+// The cache is freed when its thread exits.
+class ThreadBufferPool {
+public:
+	static constexpr size_t kMinClassShift = 6;
+
+	static constexpr size_t kMaxClassShift = 20;
+
+	static constexpr size_t kMaxClassBytes = size_t{1} << kMaxClassShift;
+
+	static constexpr size_t kDefaultMaxCachedBytes = size_t{4} << 20;
+
+	ThreadBufferPool(const ThreadBufferPool&) = delete;
+
+	ThreadBufferPool& operator=(const ThreadBufferPool&) = delete;
+
+	~ThreadBufferPool();
+
+	// The pool of the calling thread, nullptr while the thread is exiting and its pool is already gone
+	static ThreadBufferPool* Local() noexcept;
+
+	// Size of the block handed out for a request of bytes, bytes itself above kMaxClassBytes
+	static size_t BlockSize(size_t bytes) noexcept;
+
+	void* Allocate(size_t bytes);
+
+	void Deallocate(void* buffer, size_t bytes) noexcept;
+
+	// Frees cached buffers until at most keep_bytes stay cached
+	void Trim(size_t keep_bytes = 0) noexcept;
+
+	// Caps the cache; buffers above the new cap are freed right away
+	void SetMaxCachedBytes(size_t max_cached_bytes) noexcept;
+
+	size_t MaxCachedBytes() const noexcept;
+
+	size_t CachedBytes() const noexcept;
+
+	// Allocations served from the cache and by operator new since the thread started
+	size_t Hits() const noexcept;
+
+	size_t Misses() const noexcept;
+
+private:
+	static constexpr size_t kClassCount = kMaxClassShift - kMinClassShift + 1;
+
+	// A cached buffer stores the link to the next one in its first bytes
+	struct FreeBuffer {
+		FreeBuffer* next;
+	};
+
+	ThreadBufferPool() noexcept = default;
+
+	static size_t ClassOf(size_t bytes) noexcept;
+
+	static size_t ClassBytes(size_t size_class) noexcept;
+
+	static bool& Destroyed() noexcept;
+
+	FreeBuffer* free_[kClassCount] = {};
+
+	size_t cached_bytes_ = 0;
+
+	size_t max_cached_bytes_ = kDefaultMaxCachedBytes;
+
+	size_t hits_ = 0;
+
+	size_t misses_ = 0;
+};
+
+// Allocator that recycles buffers through the ThreadBufferPool of the calling thread, for
+// short-lived vectors of similar capacities created and destroyed at a high rate.
+// Vector<T, PoolAllocator<T>, PoolClassGrowth<>> also sizes its buffers to fill whole classes.
+template<typename T>
+class PoolAllocator {
+	static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "PoolAllocator does not over-align buffers");
+
+public:
+	using value_type = T;
+
+	using is_always_equal = std::true_type;
+
+	PoolAllocator() noexcept = default;
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+	T* allocate(size_t n);
+
+	void deallocate(T* buf, size_t n) noexcept;
+
+	friend bool operator==(const PoolAllocator&, const PoolAllocator&) noexcept {return true;}
+
+	friend bool operator!=(const PoolAllocator&, const PoolAllocator&) noexcept {return false;}
+};
+
+// Rounds the capacity chosen by Base up so the buffer fills its ThreadBufferPool size class
+template<typename Base = DoublingGrowth>
+struct PoolClassGrowth {
+	static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept;
+};
+
+inline ThreadBufferPool::~ThreadBufferPool() {
+	Trim();
+	Destroyed() = true;
+}
+
+inline ThreadBufferPool* ThreadBufferPool::Local() noexcept {
+	// Vectors destroyed by later thread_local destructors free their buffers directly
+	if (Destroyed()) {
+		return nullptr;
+	}
+	static thread_local ThreadBufferPool pool;
+	return &pool;
+}
+
+inline size_t ThreadBufferPool::BlockSize(size_t bytes) noexcept {
+	return bytes > kMaxClassBytes ? bytes : ClassBytes(ClassOf(bytes));
+}
+
+inline void* ThreadBufferPool::Allocate(size_t bytes) {
+	if (bytes > kMaxClassBytes) {
+		++misses_;
+		return operator new(bytes);
+	}
+	size_t size_class = ClassOf(bytes);
+	if (FreeBuffer* buffer = free_[size_class]) {
+		free_[size_class] = buffer->next;
+		cached_bytes_ -= ClassBytes(size_class);
+		++hits_;
+		return buffer;
+	}
+	++misses_;
+	return operator new(ClassBytes(size_class));
+}
+
+inline void ThreadBufferPool::Deallocate(void* buffer, size_t bytes) noexcept {
+	if (bytes > kMaxClassBytes) {
+		operator delete(buffer, bytes);
+		return;
+	}
+	size_t size_class = ClassOf(bytes);
+	size_t class_bytes = ClassBytes(size_class);
+	if (cached_bytes_ + class_bytes > max_cached_bytes_) {
+		operator delete(buffer, class_bytes);
+		return;
+	}
+	free_[size_class] = new (buffer) FreeBuffer{free_[size_class]};
+	cached_bytes_ += class_bytes;
+}
+
+inline void ThreadBufferPool::Trim(size_t keep_bytes) noexcept {
+	// The largest buffers go first: they hold the most memory and are reused the least
+	for (size_t size_class = kClassCount; size_class-- > 0 && cached_bytes_ > keep_bytes;) {
+		while (free_[size_class] != nullptr && cached_bytes_ > keep_bytes) {
+			FreeBuffer* buffer = free_[size_class];
+			free_[size_class] = buffer->next;
+			cached_bytes_ -= ClassBytes(size_class);
+			operator delete(buffer, ClassBytes(size_class));
+		}
+	}
+}
+
+inline void ThreadBufferPool::SetMaxCachedBytes(size_t max_cached_bytes) noexcept {
+	max_cached_bytes_ = max_cached_bytes;
+	Trim(max_cached_bytes);
+}
+
+inline size_t ThreadBufferPool::MaxCachedBytes() const noexcept {
+	return max_cached_bytes_;
+}
+
+inline size_t ThreadBufferPool::CachedBytes() const noexcept {
+	return cached_bytes_;
+}
+
+inline size_t ThreadBufferPool::Hits() const noexcept {
+	return hits_;
+}
+
+inline size_t ThreadBufferPool::Misses() const noexcept {
+	return misses_;
+}
+
+inline size_t ThreadBufferPool::ClassOf(size_t bytes) noexcept {
+	size_t size_class = 0;
+	while (ClassBytes(size_class) < bytes) {
+		++size_class;
+	}
+	return size_class;
+}
+
+inline size_t ThreadBufferPool::ClassBytes(size_t size_class) noexcept {
+	return size_t{1} << (size_class + kMinClassShift);
+}
+
+inline bool& ThreadBufferPool::Destroyed() noexcept {
+	// Trivially destructible, so it stays readable after the pool itself is destroyed
+	static thread_local bool destroyed = false;
+	return destroyed;
+}
+
+template<typename T>
+T* PoolAllocator<T>::allocate(size_t n) {
+	if (n > SIZE_MAX / sizeof(T)) {
+		throw std::bad_array_new_length();
+	}
+	size_t bytes = n * sizeof(T);
+	ThreadBufferPool* pool = ThreadBufferPool::Local();
+	return static_cast<T*>(pool != nullptr ? pool->Allocate(bytes) : operator new(ThreadBufferPool::BlockSize(bytes)));
+}
+
+template<typename T>
+void PoolAllocator<T>::deallocate(T* buf, size_t n) noexcept {
+	size_t bytes = n * sizeof(T);
+	if (ThreadBufferPool* pool = ThreadBufferPool::Local()) {
+		pool->Deallocate(buf, bytes);
+	}
+	else {
+		operator delete(buf, ThreadBufferPool::BlockSize(bytes));
+	}
+}
+
+template<typename Base>
+size_t PoolClassGrowth<Base>::NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept {
+	size_t base = Base::NextCapacity(capacity, required, element_size);
+	if (base > ThreadBufferPool::kMaxClassBytes / element_size) {
+		return base;
+	}
+	return ThreadBufferPool::BlockSize(base * element_size) / element_size;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "mmap_memory.h"
+
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+inline constexpr size_t kDefaultMmapThreshold = size_t{1} << 20;
+
+// Allocator whose buffers can grow in place. Blocks smaller than MmapThreshold bytes come
+// from malloc and are resized with realloc, larger ones are anonymous mappings resized with
+// mremap, so growing a big buffer neither copies it nor needs the old and new blocks at once.
+//
+// Vector uses reallocate() only for trivially relocatable element types; for the rest
+// this behaves like a malloc-based std::allocator.
+template<typename T, size_t MmapThreshold = kDefaultMmapThreshold>
+class ReallocAllocator {
+	static_assert(alignof(T) <= alignof(std::max_align_t), "ReallocAllocator does not support over-aligned types");
+
+public:
+	using value_type = T;
+
+	using is_always_equal = std::true_type;
+
+	template<typename U>
+	struct rebind {
+		using other = ReallocAllocator<U, MmapThreshold>;
+	};
+
+	ReallocAllocator() noexcept = default;
+
+	template<typename U>
+	ReallocAllocator(const ReallocAllocator<U, MmapThreshold>&) noexcept {}
+
+	T* allocate(size_t n);
+
+	void deallocate(T* buf, size_t n) noexcept;
+
+	// Resizes a block keeping its bytes, possibly at a new address. Returns nullptr and leaves
+	// the block untouched on failure
+	T* reallocate(T* buf, size_t old_n, size_t new_n) noexcept;
+
+	friend bool operator==(const ReallocAllocator&, const ReallocAllocator&) noexcept {return true;}
+
+	friend bool operator!=(const ReallocAllocator&, const ReallocAllocator&) noexcept {return false;}
+
+private:
+	static bool IsMapped(size_t bytes) noexcept;
+
+	static size_t MappedSize(size_t bytes) noexcept;
+
+	static void* AllocateBytes(size_t bytes) noexcept;
+
+	static void DeallocateBytes(void* buf, size_t bytes) noexcept;
+};
+
+template<typename T, size_t MmapThreshold>
+T* ReallocAllocator<T, MmapThreshold>::allocate(size_t n) {
+	if (n > SIZE_MAX / sizeof(T)) {
+		throw std::bad_array_new_length();
+	}
+	void* buf = AllocateBytes(n * sizeof(T));
+	if (buf == nullptr) {
+		throw std::bad_alloc();
+	}
+	return static_cast<T*>(buf);
+}
+
+template<typename T, size_t MmapThreshold>
+void ReallocAllocator<T, MmapThreshold>::deallocate(T* buf, size_t n) noexcept {
+	DeallocateBytes(buf, n * sizeof(T));
+}
+
+template<typename T, size_t MmapThreshold>
+T* ReallocAllocator<T, MmapThreshold>::reallocate(T* buf, size_t old_n, size_t new_n) noexcept {
+	if (new_n > SIZE_MAX / sizeof(T)) {
+		return nullptr;
+	}
+	size_t old_bytes = old_n * sizeof(T);
+	size_t new_bytes = new_n * sizeof(T);
+	if (!IsMapped(old_bytes) && !IsMapped(new_bytes)) {
+		return static_cast<T*>(std::realloc(buf, new_bytes));
+	}
+	if (IsMapped(old_bytes) && IsMapped(new_bytes)) {
+		return static_cast<T*>(MmapMemory::Remap(buf, MappedSize(old_bytes), MappedSize(new_bytes)));
+	}
+	// Crossing the threshold changes the backing, which needs one copy
+	void* result = AllocateBytes(new_bytes);
+	if (result != nullptr) {
+		std::memcpy(result, buf, old_bytes < new_bytes ? old_bytes : new_bytes);
+		DeallocateBytes(buf, old_bytes);
+	}
+	return static_cast<T*>(result);
+}
+
+template<typename T, size_t MmapThreshold>
+bool ReallocAllocator<T, MmapThreshold>::IsMapped(size_t bytes) noexcept {
+	return bytes >= MmapThreshold;
+}
+
+template<typename T, size_t MmapThreshold>
+size_t ReallocAllocator<T, MmapThreshold>::MappedSize(size_t bytes) noexcept {
+	return MmapMemory::RoundUp(bytes, MmapMemory::PageSize());
+}
+
+template<typename T, size_t MmapThreshold>
+void* ReallocAllocator<T, MmapThreshold>::AllocateBytes(size_t bytes) noexcept {
+	return IsMapped(bytes) ? MmapMemory::MapAnonymous(MappedSize(bytes)) : std::malloc(bytes);
+}
+
+template<typename T, size_t MmapThreshold>
+void ReallocAllocator<T, MmapThreshold>::DeallocateBytes(void* buf, size_t bytes) noexcept {
+	if (IsMapped(bytes)) {
+		MmapMemory::Unmap(buf, MappedSize(bytes));
+	}
+	else {
+		std::free(buf);
+	}
+}
@@ -0,0 +1,508 @@
+#pragma once
+
+#include "vector.h"
+#include "column_span.h"
+
+// Circular buffer with amortized O(1) insertion and removal at both ends, for queues that would
+// otherwise erase from the front of a Vector. Elements live in a single RawMemory buffer starting
+// at head_ and wrapping around its end, so the contents are at most two contiguous runs:
+// ArrayOne() from the front up to the end of the buffer and ArrayTwo() from the start of the
+// buffer. Growth follows GrowthPolicy and unwraps the contents to the start of the new buffer,
+// with the same exception guarantees as Vector.
+template<typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
+class RingVector {
+	template<bool Const>
+	class Iterator;
+
+public:
+	using value_type = T;
+
+	using allocator_type = Allocator;
+
+	using iterator = Iterator<false>;
+
+	using const_iterator = Iterator<true>;
+
+	RingVector() noexcept(std::is_nothrow_default_constructible_v<Allocator>) = default;
+
+	explicit RingVector(const Allocator& alloc) noexcept;
+
+	RingVector(const RingVector& other);
+
+	RingVector(RingVector&& other) noexcept;
+
+	~RingVector();
+
+	RingVector& operator=(const RingVector& rhs);
+
+	RingVector& operator=(RingVector&& rhs) noexcept;
+
+	iterator begin() noexcept;
+
+	iterator end() noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	void Swap(RingVector& other) noexcept;
+
+	void Reserve(size_t new_capacity);
+
+	void ShrinkToFit();
+
+	void Clear() noexcept;
+
+	template<typename... Args>
+	T& EmplaceBack(Args&&... args);
+
+	template<typename... Args>
+	T& EmplaceFront(Args&&... args);
+
+	T& PushBack(const T& value);
+
+	T& PushBack(T&& value);
+
+	T& PushFront(const T& value);
+
+	T& PushFront(T&& value);
+
+	void PopBack() noexcept;
+
+	void PopFront() noexcept;
+
+	T& Front() noexcept;
+
+	const T& Front() const noexcept;
+
+	T& Back() noexcept;
+
+	const T& Back() const noexcept;
+
+	// The elements from the front up to the end of the buffer
+	ColumnSpan<T> ArrayOne() noexcept;
+
+	ColumnSpan<const T> ArrayOne() const noexcept;
+
+	// The elements that wrapped around to the start of the buffer, empty when the contents are contiguous
+	ColumnSpan<T> ArrayTwo() noexcept;
+
+	ColumnSpan<const T> ArrayTwo() const noexcept;
+
+	const T& operator[](size_t index) const noexcept;
+
+	T& operator[](size_t index) noexcept;
+
+private:
+	// Position in the buffer of the element at index
+	size_t Physical(size_t index) const noexcept;
+
+	size_t NextCapacity(size_t required) const noexcept;
+
+	// Moves the elements in order into new_data starting at offset. If copying throws, new_data
+	// holds no elements and *this is unchanged
+	void RelocateInto(RawMemory<T, Allocator>& new_data, size_t offset);
+
+	void Reallocate(size_t new_capacity);
+
+	// Builds the new element in a grown buffer before moving the old ones, so args may refer to an element
+	template<typename... Args>
+	ADVANCED_VECTOR_COLD T& EmplaceWithReallocate(bool front, Args&&... args);
+
+	RawMemory<T, Allocator> data_;
+
+	size_t head_ = 0;
+
+	size_t size_ = 0;
+};
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<bool Const>
+class RingVector<T, Allocator, GrowthPolicy>::Iterator {
+	using Owner = std::conditional_t<Const, const RingVector, RingVector>;
+
+public:
+	using iterator_category = std::random_access_iterator_tag;
+
+	using value_type = T;
+
+	using difference_type = ptrdiff_t;
+
+	using pointer = std::conditional_t<Const, const T*, T*>;
+
+	using reference = std::conditional_t<Const, const T&, T&>;
+
+	Iterator() noexcept = default;
+
+	Iterator(Owner* owner, size_t index) noexcept : owner_(owner), index_(index) {}
+
+	// iterator converts to const_iterator
+	template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+	Iterator(const Iterator<OtherConst>& other) noexcept : owner_(other.owner_), index_(other.index_) {}
+
+	reference operator*() const noexcept {return (*owner_)[index_];}
+
+	pointer operator->() const noexcept {return &(*owner_)[index_];}
+
+	reference operator[](difference_type n) const noexcept {return (*owner_)[index_ + n];}
+
+	Iterator& operator++() noexcept {++index_; return *this;}
+
+	Iterator operator++(int) noexcept {Iterator old = *this; ++index_; return old;}
+
+	Iterator& operator--() noexcept {--index_; return *this;}
+
+	Iterator operator--(int) noexcept {Iterator old = *this; --index_; return old;}
+
+	Iterator& operator+=(difference_type n) noexcept {index_ += n; return *this;}
+
+	Iterator& operator-=(difference_type n) noexcept {index_ -= n; return *this;}
+
+	friend Iterator operator+(Iterator it, difference_type n) noexcept {return it += n;}
+
+	friend Iterator operator+(difference_type n, Iterator it) noexcept {return it += n;}
+
+	friend Iterator operator-(Iterator it, difference_type n) noexcept {return it -= n;}
+
+	friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+		return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+	}
+
+	friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ == rhs.index_;}
+
+	friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ != rhs.index_;}
+
+	friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ < rhs.index_;}
+
+	friend bool operator>(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ > rhs.index_;}
+
+	friend bool operator<=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ <= rhs.index_;}
+
+	friend bool operator>=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ >= rhs.index_;}
+
+private:
+	friend class Iterator<!Const>;
+
+	Owner* owner_ = nullptr;
+
+	size_t index_ = 0;
+};
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+RingVector<T, Allocator, GrowthPolicy>::RingVector(const Allocator& alloc) noexcept
+	: data_(alloc)
+{
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+RingVector<T, Allocator, GrowthPolicy>::RingVector(const RingVector& other)
+	: data_(other.size_, std::allocator_traits<Allocator>::select_on_container_copy_construction(other.data_.GetAllocator()))
+{
+	ColumnSpan<const T> first = other.ArrayOne();
+	ColumnSpan<const T> second = other.ArrayTwo();
+	std::uninitialized_copy_n(first.Data(), first.Size(), data_.GetAddress());
+	try {
+		std::uninitialized_copy_n(second.Data(), second.Size(), data_ + first.Size());
+	}
+	catch (...) {
+		std::destroy_n(data_.GetAddress(), first.Size());
+		throw;
+	}
+	size_ = other.size_;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+RingVector<T, Allocator, GrowthPolicy>::RingVector(RingVector&& other) noexcept
+	: data_(std::move(other.data_)), head_(std::exchange(other.head_, 0)), size_(std::exchange(other.size_, 0))
+{
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+RingVector<T, Allocator, GrowthPolicy>::~RingVector() {
+	Clear();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+RingVector<T, Allocator, GrowthPolicy>& RingVector<T, Allocator, GrowthPolicy>::operator=(const RingVector& rhs) {
+	if (this != &rhs) {
+		RingVector copy(rhs);
+		Swap(copy);
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+RingVector<T, Allocator, GrowthPolicy>& RingVector<T, Allocator, GrowthPolicy>::operator=(RingVector&& rhs) noexcept {
+	if (this != &rhs) {
+		RingVector moved(std::move(rhs));
+		Swap(moved);
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename RingVector<T, Allocator, GrowthPolicy>::iterator RingVector<T, Allocator, GrowthPolicy>::begin() noexcept {
+	return {this, 0};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename RingVector<T, Allocator, GrowthPolicy>::iterator RingVector<T, Allocator, GrowthPolicy>::end() noexcept {
+	return {this, size_};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename RingVector<T, Allocator, GrowthPolicy>::const_iterator RingVector<T, Allocator, GrowthPolicy>::begin() const noexcept {
+	return {this, 0};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename RingVector<T, Allocator, GrowthPolicy>::const_iterator RingVector<T, Allocator, GrowthPolicy>::end() const noexcept {
+	return {this, size_};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename RingVector<T, Allocator, GrowthPolicy>::const_iterator RingVector<T, Allocator, GrowthPolicy>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename RingVector<T, Allocator, GrowthPolicy>::const_iterator RingVector<T, Allocator, GrowthPolicy>::cend() const noexcept {
+	return end();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+size_t RingVector<T, Allocator, GrowthPolicy>::Size() const noexcept {
+	return size_;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+size_t RingVector<T, Allocator, GrowthPolicy>::Capacity() const noexcept {
+	return data_.Capacity();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::Swap(RingVector& other) noexcept {
+	data_.Swap(other.data_);
+	std::swap(head_, other.head_);
+	std::swap(size_, other.size_);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::Reserve(size_t new_capacity) {
+	if (new_capacity > data_.Capacity()) {
+		Reallocate(new_capacity);
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::ShrinkToFit() {
+	if (size_ != data_.Capacity()) {
+		Reallocate(size_);
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::Clear() noexcept {
+	ColumnSpan<T> first = ArrayOne();
+	ColumnSpan<T> second = ArrayTwo();
+	std::destroy_n(first.Data(), first.Size());
+	std::destroy_n(second.Data(), second.Size());
+	head_ = 0;
+	size_ = 0;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename... Args>
+T& RingVector<T, Allocator, GrowthPolicy>::EmplaceBack(Args&&... args) {
+	if (ADVANCED_VECTOR_UNLIKELY(size_ == data_.Capacity())) {
+		return EmplaceWithReallocate(false, std::forward<Args>(args)...);
+	}
+	T* slot = new (data_ + Physical(size_)) T(std::forward<Args>(args)...);
+	++size_;
+	return *slot;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename... Args>
+T& RingVector<T, Allocator, GrowthPolicy>::EmplaceFront(Args&&... args) {
+	if (ADVANCED_VECTOR_UNLIKELY(size_ == data_.Capacity())) {
+		return EmplaceWithReallocate(true, std::forward<Args>(args)...);
+	}
+	size_t new_head = head_ == 0 ? data_.Capacity() - 1 : head_ - 1;
+	T* slot = new (data_ + new_head) T(std::forward<Args>(args)...);
+	head_ = new_head;
+	++size_;
+	return *slot;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::PushFront(const T& value) {
+	return EmplaceFront(value);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::PushFront(T&& value) {
+	return EmplaceFront(std::move(value));
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::PopBack() noexcept {
+	assert(size_ > 0);
+	std::destroy_at(&Back());
+	--size_;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::PopFront() noexcept {
+	assert(size_ > 0);
+	std::destroy_at(&Front());
+	--size_;
+	// An emptied ring starts over at the beginning of the buffer, keeping ArrayOne as long as possible
+	head_ = size_ == 0 || head_ + 1 == data_.Capacity() ? 0 : head_ + 1;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::Front() noexcept {
+	return (*this)[0];
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+const T& RingVector<T, Allocator, GrowthPolicy>::Front() const noexcept {
+	return (*this)[0];
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::Back() noexcept {
+	return (*this)[size_ - 1];
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+const T& RingVector<T, Allocator, GrowthPolicy>::Back() const noexcept {
+	return (*this)[size_ - 1];
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ColumnSpan<T> RingVector<T, Allocator, GrowthPolicy>::ArrayOne() noexcept {
+	return {data_ + head_, std::min(size_, data_.Capacity() - head_)};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ColumnSpan<const T> RingVector<T, Allocator, GrowthPolicy>::ArrayOne() const noexcept {
+	ColumnSpan<T> span = const_cast<RingVector&>(*this).ArrayOne();
+	return {span.Data(), span.Size()};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ColumnSpan<T> RingVector<T, Allocator, GrowthPolicy>::ArrayTwo() noexcept {
+	return {data_.GetAddress(), size_ - std::min(size_, data_.Capacity() - head_)};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ColumnSpan<const T> RingVector<T, Allocator, GrowthPolicy>::ArrayTwo() const noexcept {
+	ColumnSpan<T> span = const_cast<RingVector&>(*this).ArrayTwo();
+	return {span.Data(), span.Size()};
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+const T& RingVector<T, Allocator, GrowthPolicy>::operator[](size_t index) const noexcept {
+	return const_cast<RingVector&>(*this)[index];
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& RingVector<T, Allocator, GrowthPolicy>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return data_[Physical(index)];
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+size_t RingVector<T, Allocator, GrowthPolicy>::Physical(size_t index) const noexcept {
+	size_t position = head_ + index;
+	return position < data_.Capacity() ? position : position - data_.Capacity();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+size_t RingVector<T, Allocator, GrowthPolicy>::NextCapacity(size_t required) const noexcept {
+	size_t new_capacity = GrowthPolicy::NextCapacity(data_.Capacity(), required, sizeof(T));
+	assert(new_capacity >= required);
+	return new_capacity;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::RelocateInto(RawMemory<T, Allocator>& new_data, size_t offset) {
+	ColumnSpan<T> first = ArrayOne();
+	ColumnSpan<T> second = ArrayTwo();
+	T* to = new_data + offset;
+	if constexpr (IsTriviallyRelocatableV<T> || std::is_nothrow_move_constructible_v<T>
+	              || !std::is_copy_constructible_v<T>) {
+		SafeRelocate(first.Data(), first.Size(), to);
+		try {
+			SafeRelocate(second.Data(), second.Size(), to + first.Size());
+		}
+		catch (...) {
+			// Only a throwing move of a move-only type gets here; the first run is gone, so leave an empty ring
+			std::destroy_n(to, first.Size());
+			std::destroy_n(second.Data(), second.Size());
+			head_ = 0;
+			size_ = 0;
+			throw;
+		}
+	}
+	else {
+		// Both runs are copied before any source element is destroyed
+		std::uninitialized_copy_n(first.Data(), first.Size(), to);
+		try {
+			std::uninitialized_copy_n(second.Data(), second.Size(), to + first.Size());
+		}
+		catch (...) {
+			std::destroy_n(to, first.Size());
+			throw;
+		}
+		std::destroy_n(first.Data(), first.Size());
+		std::destroy_n(second.Data(), second.Size());
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void RingVector<T, Allocator, GrowthPolicy>::Reallocate(size_t new_capacity) {
+	RawMemory<T, Allocator> new_data{new_capacity, data_.GetAllocator()};
+	RelocateInto(new_data, 0);
+	data_.Swap(new_data);
+	head_ = 0;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename... Args>
+T& RingVector<T, Allocator, GrowthPolicy>::EmplaceWithReallocate(bool front, Args&&... args) {
+	RawMemory<T, Allocator> new_data{NextCapacity(size_ + 1), data_.GetAllocator()};
+	size_t slot = front ? 0 : size_;
+	new (new_data + slot) T(std::forward<Args>(args)...);
+	try {
+		RelocateInto(new_data, front ? 1 : 0);
+	}
+	catch (...) {
+		std::destroy_at(new_data + slot);
+		throw;
+	}
+	data_.Swap(new_data);
+	head_ = 0;
+	++size_;
+	return data_[slot];
+}
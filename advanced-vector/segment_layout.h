@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Index arithmetic for containers built from segments of doubling size that never move once
+// allocated. Segment 0 holds 2^FirstShift elements and every following segment is twice the
+// previous one, so segment k starts at index 2^(FirstShift+k) - 2^FirstShift. Adding
+// 2^FirstShift to an index makes its highest set bit name the segment and the remaining bits
+// the offset inside it, so a lookup is an add, a bit scan and a mask.
+template<unsigned FirstShift>
+struct SegmentLayout {
+	static_assert(FirstShift < 32);
+
+	// Enough segments to address every index up to SIZE_MAX - 2^FirstShift
+	static constexpr size_t kMaxSegments = sizeof(size_t) * 8 - FirstShift;
+
+	static constexpr size_t kFirstSize = size_t{1} << FirstShift;
+
+	static constexpr size_t SegmentOf(size_t index) noexcept;
+
+	static constexpr size_t OffsetOf(size_t index) noexcept;
+
+	static constexpr size_t SegmentSize(size_t segment) noexcept;
+
+	static constexpr size_t SegmentStart(size_t segment) noexcept;
+
+	// Number of segments needed to hold count elements
+	static constexpr size_t SegmentCount(size_t count) noexcept;
+
+private:
+	static constexpr unsigned HighestBit(size_t value) noexcept;
+};
+
+template<unsigned FirstShift>
+constexpr unsigned SegmentLayout<FirstShift>::HighestBit(size_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<unsigned>(sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(value));
+#else
+	unsigned bit = 0;
+	while (value >>= 1) {
+		++bit;
+	}
+	return bit;
+#endif
+}
+
+template<unsigned FirstShift>
+constexpr size_t SegmentLayout<FirstShift>::SegmentOf(size_t index) noexcept {
+	size_t biased = index + kFirstSize;
+	return HighestBit(biased) - FirstShift;
+}
+
+template<unsigned FirstShift>
+constexpr size_t SegmentLayout<FirstShift>::OffsetOf(size_t index) noexcept {
+	size_t biased = index + kFirstSize;
+	return biased - (size_t{1} << HighestBit(biased));
+}
+
+template<unsigned FirstShift>
+constexpr size_t SegmentLayout<FirstShift>::SegmentSize(size_t segment) noexcept {
+	return size_t{1} << (FirstShift + segment);
+}
+
+template<unsigned FirstShift>
+constexpr size_t SegmentLayout<FirstShift>::SegmentStart(size_t segment) noexcept {
+	return SegmentSize(segment) - kFirstSize;
+}
+
+template<unsigned FirstShift>
+constexpr size_t SegmentLayout<FirstShift>::SegmentCount(size_t count) noexcept {
+	return count == 0 ? 0 : SegmentOf(count - 1) + 1;
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+#include "vector.h"
+#include "segment_layout.h"
+
+// Vector whose elements never move. Storage is a list of RawMemory segments of doubling size
+// (see SegmentLayout): growing adds a segment and leaves the existing ones alone, so pointers
+// and references to elements stay valid until the element is removed, and PushBack never pays
+// for copying the whole contents. Indexing is an add, a bit scan and two loads.
+template<typename T, typename Allocator = std::allocator<T>, unsigned FirstShift = 4>
+class SegmentedVector {
+	using Layout = SegmentLayout<FirstShift>;
+
+	using AllocTraits = std::allocator_traits<Allocator>;
+
+	template<bool Const>
+	class Iterator;
+
+public:
+	using value_type = T;
+
+	using allocator_type = Allocator;
+
+	using iterator = Iterator<false>;
+
+	using const_iterator = Iterator<true>;
+
+	SegmentedVector() noexcept(std::is_nothrow_default_constructible_v<Allocator>) = default;
+
+	explicit SegmentedVector(const Allocator& alloc) noexcept;
+
+	explicit SegmentedVector(size_t size, const Allocator& alloc = Allocator());
+
+	SegmentedVector(const SegmentedVector& other);
+
+	SegmentedVector(SegmentedVector&& other) noexcept;
+
+	~SegmentedVector();
+
+	// Adopts the allocator of rhs under propagate_on_container_copy_assignment, like Vector
+	SegmentedVector& operator=(const SegmentedVector& rhs);
+
+	// Moves element by element when the allocator does not propagate and the two are unequal
+	SegmentedVector& operator=(SegmentedVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+	                                                            || AllocTraits::is_always_equal::value);
+
+	iterator begin() noexcept;
+
+	iterator end() noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	// Swaps the allocators under propagate_on_container_swap, otherwise they must be equal
+	void Swap(SegmentedVector& other) noexcept;
+
+	Allocator GetAllocator() const noexcept;
+
+	// Allocates segments until the capacity reaches new_capacity; nothing moves
+	void Reserve(size_t new_capacity);
+
+	// Frees the segments past the one holding the last element
+	void ShrinkToFit() noexcept;
+
+	void Clear() noexcept;
+
+	void Resize(size_t new_size);
+
+	template<typename... Args>
+	T& EmplaceBack(Args&&... args);
+
+	T& PushBack(const T& value);
+
+	T& PushBack(T&& value);
+
+	void PopBack() noexcept;
+
+	const T& operator[](size_t index) const noexcept;
+
+	T& operator[](size_t index) noexcept;
+
+private:
+	// Appends the next segment
+	void AddSegment();
+
+	// Exchanges the segments and sizes, leaving the allocators alone
+	void SwapContents(SegmentedVector& other) noexcept;
+
+	Vector<RawMemory<T, Allocator>> segments_;
+
+	Allocator alloc_;
+
+	size_t size_ = 0;
+};
+
+template<typename T, typename Allocator, unsigned FirstShift>
+template<bool Const>
+class SegmentedVector<T, Allocator, FirstShift>::Iterator {
+	using Owner = std::conditional_t<Const, const SegmentedVector, SegmentedVector>;
+
+public:
+	using iterator_category = std::random_access_iterator_tag;
+
+	using value_type = T;
+
+	using difference_type = ptrdiff_t;
+
+	using pointer = std::conditional_t<Const, const T*, T*>;
+
+	using reference = std::conditional_t<Const, const T&, T&>;
+
+	Iterator() noexcept = default;
+
+	Iterator(Owner* owner, size_t index) noexcept : owner_(owner), index_(index) {}
+
+	// iterator converts to const_iterator
+	template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+	Iterator(const Iterator<OtherConst>& other) noexcept : owner_(other.owner_), index_(other.index_) {}
+
+	reference operator*() const noexcept {return (*owner_)[index_];}
+
+	pointer operator->() const noexcept {return &(*owner_)[index_];}
+
+	reference operator[](difference_type n) const noexcept {return (*owner_)[index_ + n];}
+
+	Iterator& operator++() noexcept {++index_; return *this;}
+
+	Iterator operator++(int) noexcept {Iterator old = *this; ++index_; return old;}
+
+	Iterator& operator--() noexcept {--index_; return *this;}
+
+	Iterator operator--(int) noexcept {Iterator old = *this; --index_; return old;}
+
+	Iterator& operator+=(difference_type n) noexcept {index_ += n; return *this;}
+
+	Iterator& operator-=(difference_type n) noexcept {index_ -= n; return *this;}
+
+	friend Iterator operator+(Iterator it, difference_type n) noexcept {return it += n;}
+
+	friend Iterator operator+(difference_type n, Iterator it) noexcept {return it += n;}
+
+	friend Iterator operator-(Iterator it, difference_type n) noexcept {return it -= n;}
+
+	friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+		return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+	}
+
+	friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ == rhs.index_;}
+
+	friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ != rhs.index_;}
+
+	friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ < rhs.index_;}
+
+	friend bool operator>(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ > rhs.index_;}
+
+	friend bool operator<=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ <= rhs.index_;}
+
+	friend bool operator>=(const Iterator& lhs, const Iterator& rhs) noexcept {return lhs.index_ >= rhs.index_;}
+
+private:
+	friend class Iterator<!Const>;
+
+	Owner* owner_ = nullptr;
+
+	size_t index_ = 0;
+};
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>::SegmentedVector(const Allocator& alloc) noexcept
+	: alloc_(alloc)
+{
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>::SegmentedVector(size_t size, const Allocator& alloc)
+	: SegmentedVector(alloc)
+{
+	Resize(size);
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>::SegmentedVector(const SegmentedVector& other)
+	: SegmentedVector(AllocTraits::select_on_container_copy_construction(other.alloc_))
+{
+	Reserve(other.size_);
+	for (const T& value : other) {
+		EmplaceBack(value);
+	}
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>::SegmentedVector(SegmentedVector&& other) noexcept
+	: segments_(std::move(other.segments_)), alloc_(other.alloc_), size_(std::exchange(other.size_, 0))
+{
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>::~SegmentedVector() {
+	Clear();
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>& SegmentedVector<T, Allocator, FirstShift>::operator=(const SegmentedVector& rhs) {
+	if (this != &rhs) {
+		// The copy is built with the allocator this vector ends up with, so a throwing copy leaves it unchanged
+		SegmentedVector copy(AllocTraits::propagate_on_container_copy_assignment::value ? rhs.alloc_ : alloc_);
+		copy.Reserve(rhs.size_);
+		for (const T& value : rhs) {
+			copy.EmplaceBack(value);
+		}
+		SwapContents(copy);
+		if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+			alloc_ = rhs.alloc_;
+		}
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+SegmentedVector<T, Allocator, FirstShift>& SegmentedVector<T, Allocator, FirstShift>::operator=(SegmentedVector&& rhs)
+	noexcept(AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
+	if (this != &rhs) {
+		if (AllocTraits::propagate_on_container_move_assignment::value || alloc_ == rhs.alloc_) {
+			SegmentedVector moved(std::move(rhs));
+			SwapContents(moved);
+			if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+				alloc_ = std::move(moved.alloc_);
+			}
+		}
+		else {
+			// The segments belong to an unequal allocator that stays with rhs
+			SegmentedVector moved(alloc_);
+			moved.Reserve(rhs.size_);
+			for (T& value : rhs) {
+				moved.EmplaceBack(std::move(value));
+			}
+			SwapContents(moved);
+			rhs.Clear();
+		}
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+typename SegmentedVector<T, Allocator, FirstShift>::iterator SegmentedVector<T, Allocator, FirstShift>::begin() noexcept {
+	return {this, 0};
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+typename SegmentedVector<T, Allocator, FirstShift>::iterator SegmentedVector<T, Allocator, FirstShift>::end() noexcept {
+	return {this, size_};
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+typename SegmentedVector<T, Allocator, FirstShift>::const_iterator SegmentedVector<T, Allocator, FirstShift>::begin() const noexcept {
+	return {this, 0};
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+typename SegmentedVector<T, Allocator, FirstShift>::const_iterator SegmentedVector<T, Allocator, FirstShift>::end() const noexcept {
+	return {this, size_};
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+typename SegmentedVector<T, Allocator, FirstShift>::const_iterator SegmentedVector<T, Allocator, FirstShift>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+typename SegmentedVector<T, Allocator, FirstShift>::const_iterator SegmentedVector<T, Allocator, FirstShift>::cend() const noexcept {
+	return end();
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+size_t SegmentedVector<T, Allocator, FirstShift>::Size() const noexcept {
+	return size_;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+size_t SegmentedVector<T, Allocator, FirstShift>::Capacity() const noexcept {
+	return Layout::SegmentStart(segments_.Size());
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::Swap(SegmentedVector& other) noexcept {
+	if constexpr (AllocTraits::propagate_on_container_swap::value) {
+		using std::swap;
+		swap(alloc_, other.alloc_);
+	}
+	else {
+		assert(alloc_ == other.alloc_);
+	}
+	SwapContents(other);
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+Allocator SegmentedVector<T, Allocator, FirstShift>::GetAllocator() const noexcept {
+	return alloc_;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::Reserve(size_t new_capacity) {
+	while (Capacity() < new_capacity) {
+		AddSegment();
+	}
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::ShrinkToFit() noexcept {
+	size_t needed = Layout::SegmentCount(size_);
+	while (segments_.Size() > needed) {
+		segments_.PopBack();
+	}
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::Clear() noexcept {
+	if constexpr (!std::is_trivially_destructible_v<T>) {
+		for (size_t segment = 0; segment < Layout::SegmentCount(size_); ++segment) {
+			size_t start = Layout::SegmentStart(segment);
+			std::destroy_n(segments_[segment].GetAddress(), std::min(size_ - start, Layout::SegmentSize(segment)));
+		}
+	}
+	size_ = 0;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::Resize(size_t new_size) {
+	while (size_ > new_size) {
+		PopBack();
+	}
+	Reserve(new_size);
+	while (size_ < new_size) {
+		EmplaceBack();
+	}
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+template<typename... Args>
+T& SegmentedVector<T, Allocator, FirstShift>::EmplaceBack(Args&&... args) {
+	if (size_ == Capacity()) {
+		AddSegment();
+	}
+	// A new segment that stays empty after a throwing constructor only adds capacity
+	T* slot = segments_[Layout::SegmentOf(size_)] + Layout::OffsetOf(size_);
+	new (slot) T(std::forward<Args>(args)...);
+	++size_;
+	return *slot;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+T& SegmentedVector<T, Allocator, FirstShift>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+T& SegmentedVector<T, Allocator, FirstShift>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::PopBack() noexcept {
+	assert(size_ > 0);
+	std::destroy_at(&(*this)[size_ - 1]);
+	--size_;
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+const T& SegmentedVector<T, Allocator, FirstShift>::operator[](size_t index) const noexcept {
+	return const_cast<SegmentedVector&>(*this)[index];
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+T& SegmentedVector<T, Allocator, FirstShift>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return segments_[Layout::SegmentOf(index)][Layout::OffsetOf(index)];
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::AddSegment() {
+	assert(segments_.Size() < Layout::kMaxSegments);
+	segments_.EmplaceBack(Layout::SegmentSize(segments_.Size()), alloc_);
+}
+
+template<typename T, typename Allocator, unsigned FirstShift>
+void SegmentedVector<T, Allocator, FirstShift>::SwapContents(SegmentedVector& other) noexcept {
+	segments_.Swap(other.segments_);
+	std::swap(size_, other.size_);
+}
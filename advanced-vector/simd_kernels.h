@@ -0,0 +1,415 @@
+#pragma once
+
+#include "vector.h"
+
+#include <atomic>
+#include <utility>
+
+// Vectorized scans and element-wise operations over Vectors of 4- and 8-byte arithmetic types
+// (int, float, double, int64_t, ...). Each kernel is written once over GCC/Clang vector
+// extensions and compiled for SSE2, AVX2 and AVX-512; the widest level the CPU supports is
+// picked at run time. Other compilers and CPUs get the scalar loop.
+//
+// When the allocator guarantees an alignment of at least the vector width (AlignedAllocator,
+// CacheAlignedAllocator) the kernels use aligned loads and stores. Floating-point Sum adds in a
+// different order than a scalar loop, and MinMax over data containing NaN is unspecified.
+namespace simd {
+
+	enum class Level {
+		Scalar,
+		Sse2,
+		Avx2,
+		Avx512,
+	};
+
+	// The widest level supported by the CPU
+	Level SupportedLevel() noexcept;
+
+	Level ActiveLevel() noexcept;
+
+	// Restricts the kernels to level, clamped to SupportedLevel(). Meant for tests and benchmarks
+	void SetLevel(Level level) noexcept;
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void Fill(Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept;
+
+	// Pointer to the first element equal to value, or end()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	T* Find(Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept;
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	const T* Find(const Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept;
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	size_t Count(const Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept;
+
+	// The vector must not be empty
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	std::pair<T, T> MinMax(const Vector<T, Allocator, GrowthPolicy>& vector) noexcept;
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	T Sum(const Vector<T, Allocator, GrowthPolicy>& vector) noexcept;
+
+	// dst[i] += src[i]; both vectors must have the same size
+	template<typename T, typename A1, typename G1, typename A2, typename G2>
+	void Add(Vector<T, A1, G1>& dst, const Vector<T, A2, G2>& src) noexcept;
+
+	// dst[i] *= src[i]; both vectors must have the same size
+	template<typename T, typename A1, typename G1, typename A2, typename G2>
+	void Multiply(Vector<T, A1, G1>& dst, const Vector<T, A2, G2>& src) noexcept;
+
+}//end namespace simd
+
+namespace simd_detail {
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ADVANCED_VECTOR_SIMD_X86 1
+#define ADVANCED_VECTOR_SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define ADVANCED_VECTOR_SIMD_INLINE inline
+#endif
+
+	template<typename T>
+	inline constexpr bool kSupported = std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+	inline std::atomic<simd::Level> active_level{simd::SupportedLevel()};
+
+#ifdef ADVANCED_VECTOR_SIMD_X86
+
+	template<typename T, size_t Bytes>
+	struct VectorOf {
+		typedef T type __attribute__((vector_size(Bytes)));
+	};
+
+	// Bytes is the vector width; the loads are aligned when Aligned is true. Vectors are passed by
+	// reference: by value their ABI would depend on the target the caller was compiled for
+	template<typename T, size_t Bytes, bool Aligned>
+	struct Lanes {
+		using V = typename VectorOf<T, Bytes>::type;
+
+		static constexpr size_t kCount = Bytes / sizeof(T);
+
+		static ADVANCED_VECTOR_SIMD_INLINE void Load(V& v, const T* p) noexcept {
+			if constexpr (Aligned) {
+				v = *reinterpret_cast<const V*>(__builtin_assume_aligned(p, Bytes));
+			}
+			else {
+				__builtin_memcpy(&v, p, sizeof(V));
+			}
+		}
+
+		static ADVANCED_VECTOR_SIMD_INLINE void Store(T* p, const V& v) noexcept {
+			if constexpr (Aligned) {
+				*reinterpret_cast<V*>(__builtin_assume_aligned(p, Bytes)) = v;
+			}
+			else {
+				__builtin_memcpy(p, &v, sizeof(V));
+			}
+		}
+
+		static ADVANCED_VECTOR_SIMD_INLINE void Splat(V& v, T value) noexcept {
+			v = V{} + value;
+		}
+	};
+
+#endif
+
+	// Every kernel has a method template Run<Bytes, Aligned> that processes whole vectors of Bytes
+	// bytes and finishes the tail with scalar code; Bytes == 0 means the scalar loop only
+
+	struct FillKernel {
+		template<size_t Bytes, bool Aligned, typename T>
+		static ADVANCED_VECTOR_SIMD_INLINE void Run(T* data, size_t size, T value) noexcept {
+			size_t i = 0;
+#ifdef ADVANCED_VECTOR_SIMD_X86
+			if constexpr (Bytes != 0) {
+				using L = Lanes<T, Bytes, Aligned>;
+				typename L::V splat;
+				L::Splat(splat, value);
+				for (; i + L::kCount <= size; i += L::kCount) {
+					L::Store(data + i, splat);
+				}
+			}
+#endif
+			for (; i < size; ++i) {
+				data[i] = value;
+			}
+		}
+	};
+
+	struct FindKernel {
+		template<size_t Bytes, bool Aligned, typename T>
+		static ADVANCED_VECTOR_SIMD_INLINE size_t Run(const T* data, size_t size, T value) noexcept {
+			size_t i = 0;
+#ifdef ADVANCED_VECTOR_SIMD_X86
+			if constexpr (Bytes != 0) {
+				using L = Lanes<T, Bytes, Aligned>;
+				typename L::V splat, v;
+				L::Splat(splat, value);
+				for (; i + L::kCount <= size; i += L::kCount) {
+					L::Load(v, data + i);
+					auto equal = v == splat;
+					decltype(equal) none{};
+					if (__builtin_memcmp(&equal, &none, sizeof(equal)) != 0) {
+						break;
+					}
+				}
+			}
+#endif
+			for (; i < size; ++i) {
+				if (data[i] == value) {
+					return i;
+				}
+			}
+			return size;
+		}
+	};
+
+	struct CountKernel {
+		template<size_t Bytes, bool Aligned, typename T>
+		static ADVANCED_VECTOR_SIMD_INLINE size_t Run(const T* data, size_t size, T value) noexcept {
+			size_t i = 0;
+			size_t count = 0;
+#ifdef ADVANCED_VECTOR_SIMD_X86
+			if constexpr (Bytes != 0) {
+				using L = Lanes<T, Bytes, Aligned>;
+				typename L::V splat, v;
+				L::Splat(splat, value);
+				// Matches are -1 in the lane; the lane sums are flushed before a 32-bit lane could overflow
+				constexpr size_t kFlushEvery = size_t{1} << 30;
+				while (i + L::kCount <= size) {
+					decltype(splat == splat) matches{};
+					for (size_t blocks = 0; blocks < kFlushEvery && i + L::kCount <= size; ++blocks, i += L::kCount) {
+						L::Load(v, data + i);
+						matches += v == splat;
+					}
+					for (size_t lane = 0; lane < L::kCount; ++lane) {
+						count += static_cast<size_t>(-matches[lane]);
+					}
+				}
+			}
+#endif
+			for (; i < size; ++i) {
+				count += data[i] == value;
+			}
+			return count;
+		}
+	};
+
+	struct MinMaxKernel {
+		template<size_t Bytes, bool Aligned, typename T>
+		static ADVANCED_VECTOR_SIMD_INLINE std::pair<T, T> Run(const T* data, size_t size) noexcept {
+			size_t i = 0;
+			T min = data[0];
+			T max = data[0];
+#ifdef ADVANCED_VECTOR_SIMD_X86
+			if constexpr (Bytes != 0) {
+				using L = Lanes<T, Bytes, Aligned>;
+				if (size >= L::kCount) {
+					typename L::V vmin, vmax, v;
+					L::Load(vmin, data);
+					vmax = vmin;
+					for (i = L::kCount; i + L::kCount <= size; i += L::kCount) {
+						L::Load(v, data + i);
+						vmin = v < vmin ? v : vmin;
+						vmax = v > vmax ? v : vmax;
+					}
+					for (size_t lane = 0; lane < L::kCount; ++lane) {
+						min = vmin[lane] < min ? vmin[lane] : min;
+						max = vmax[lane] > max ? vmax[lane] : max;
+					}
+				}
+			}
+#endif
+			for (; i < size; ++i) {
+				min = data[i] < min ? data[i] : min;
+				max = data[i] > max ? data[i] : max;
+			}
+			return {min, max};
+		}
+	};
+
+	struct SumKernel {
+		template<size_t Bytes, bool Aligned, typename T>
+		static ADVANCED_VECTOR_SIMD_INLINE T Run(const T* data, size_t size) noexcept {
+			size_t i = 0;
+			T sum = 0;
+#ifdef ADVANCED_VECTOR_SIMD_X86
+			if constexpr (Bytes != 0) {
+				using L = Lanes<T, Bytes, Aligned>;
+				typename L::V acc{}, v;
+				for (; i + L::kCount <= size; i += L::kCount) {
+					L::Load(v, data + i);
+					acc += v;
+				}
+				for (size_t lane = 0; lane < L::kCount; ++lane) {
+					sum += acc[lane];
+				}
+			}
+#endif
+			for (; i < size; ++i) {
+				sum += data[i];
+			}
+			return sum;
+		}
+	};
+
+	template<typename Op>
+	struct ElementwiseKernel {
+		template<size_t Bytes, bool Aligned, typename T>
+		static ADVANCED_VECTOR_SIMD_INLINE void Run(T* dst, const T* src, size_t size) noexcept {
+			size_t i = 0;
+#ifdef ADVANCED_VECTOR_SIMD_X86
+			if constexpr (Bytes != 0) {
+				using L = Lanes<T, Bytes, Aligned>;
+				typename L::V lhs, rhs;
+				for (; i + L::kCount <= size; i += L::kCount) {
+					L::Load(lhs, dst + i);
+					L::Load(rhs, src + i);
+					Op::Apply(lhs, rhs);
+					L::Store(dst + i, lhs);
+				}
+			}
+#endif
+			for (; i < size; ++i) {
+				Op::Apply(dst[i], src[i]);
+			}
+		}
+	};
+
+	struct AddOp {
+		template<typename V>
+		static ADVANCED_VECTOR_SIMD_INLINE void Apply(V& lhs, const V& rhs) noexcept {lhs += rhs;}
+	};
+
+	struct MultiplyOp {
+		template<typename V>
+		static ADVANCED_VECTOR_SIMD_INLINE void Apply(V& lhs, const V& rhs) noexcept {lhs *= rhs;}
+	};
+
+#ifdef ADVANCED_VECTOR_SIMD_X86
+
+	// The kernels are force-inlined into these, so their bodies are compiled for the target ISA
+	template<typename Kernel, size_t Alignment, typename... Args>
+	__attribute__((target("sse2"))) auto RunSse2(Args... args) noexcept {
+		return Kernel::template Run<16, (Alignment >= 16)>(args...);
+	}
+
+	template<typename Kernel, size_t Alignment, typename... Args>
+	__attribute__((target("avx2"))) auto RunAvx2(Args... args) noexcept {
+		return Kernel::template Run<32, (Alignment >= 32)>(args...);
+	}
+
+	template<typename Kernel, size_t Alignment, typename... Args>
+	__attribute__((target("avx512f"))) auto RunAvx512(Args... args) noexcept {
+		return Kernel::template Run<64, (Alignment >= 64)>(args...);
+	}
+
+#endif
+
+	template<typename Kernel, size_t Alignment, typename... Args>
+	auto Dispatch(Args... args) noexcept {
+#ifdef ADVANCED_VECTOR_SIMD_X86
+		switch (active_level.load(std::memory_order_relaxed)) {
+			case simd::Level::Avx512:
+				return RunAvx512<Kernel, Alignment>(args...);
+			case simd::Level::Avx2:
+				return RunAvx2<Kernel, Alignment>(args...);
+			case simd::Level::Sse2:
+				return RunSse2<Kernel, Alignment>(args...);
+			case simd::Level::Scalar:
+				break;
+		}
+#endif
+		return Kernel::template Run<0, false>(args...);
+	}
+
+}//end namespace simd_detail
+
+inline simd::Level simd::SupportedLevel() noexcept {
+#ifdef ADVANCED_VECTOR_SIMD_X86
+	static const Level level = [] {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) {
+			return Level::Avx512;
+		}
+		if (__builtin_cpu_supports("avx2")) {
+			return Level::Avx2;
+		}
+		if (__builtin_cpu_supports("sse2")) {
+			return Level::Sse2;
+		}
+		return Level::Scalar;
+	}();
+	return level;
+#else
+	return Level::Scalar;
+#endif
+}
+
+inline simd::Level simd::ActiveLevel() noexcept {
+	return simd_detail::active_level.load(std::memory_order_relaxed);
+}
+
+inline void simd::SetLevel(Level level) noexcept {
+	simd_detail::active_level.store(std::min(level, SupportedLevel()), std::memory_order_relaxed);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void simd::Fill(Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	constexpr size_t alignment = Vector<T, Allocator, GrowthPolicy>::kGuaranteedAlignment;
+	simd_detail::Dispatch<simd_detail::FillKernel, alignment>(vector.Data(), vector.Size(), value);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T* simd::Find(Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept {
+	const auto& const_vector = vector;
+	return vector.Data() + (Find(const_vector, value) - const_vector.Data());
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+const T* simd::Find(const Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	constexpr size_t alignment = Vector<T, Allocator, GrowthPolicy>::kGuaranteedAlignment;
+	const T* data = vector.Data();
+	return data + simd_detail::Dispatch<simd_detail::FindKernel, alignment>(data, vector.Size(), value);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+size_t simd::Count(const Vector<T, Allocator, GrowthPolicy>& vector, T value) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	constexpr size_t alignment = Vector<T, Allocator, GrowthPolicy>::kGuaranteedAlignment;
+	return simd_detail::Dispatch<simd_detail::CountKernel, alignment>(vector.Data(), vector.Size(), value);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+std::pair<T, T> simd::MinMax(const Vector<T, Allocator, GrowthPolicy>& vector) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	assert(vector.Size() != 0);
+	constexpr size_t alignment = Vector<T, Allocator, GrowthPolicy>::kGuaranteedAlignment;
+	return simd_detail::Dispatch<simd_detail::MinMaxKernel, alignment>(vector.Data(), vector.Size());
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T simd::Sum(const Vector<T, Allocator, GrowthPolicy>& vector) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	constexpr size_t alignment = Vector<T, Allocator, GrowthPolicy>::kGuaranteedAlignment;
+	return simd_detail::Dispatch<simd_detail::SumKernel, alignment>(vector.Data(), vector.Size());
+}
+
+template<typename T, typename A1, typename G1, typename A2, typename G2>
+void simd::Add(Vector<T, A1, G1>& dst, const Vector<T, A2, G2>& src) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	assert(dst.Size() == src.Size());
+	constexpr size_t alignment = std::min(Vector<T, A1, G1>::kGuaranteedAlignment, Vector<T, A2, G2>::kGuaranteedAlignment);
+	simd_detail::Dispatch<simd_detail::ElementwiseKernel<simd_detail::AddOp>, alignment>(dst.Data(), src.Data(), dst.Size());
+}
+
+template<typename T, typename A1, typename G1, typename A2, typename G2>
+void simd::Multiply(Vector<T, A1, G1>& dst, const Vector<T, A2, G2>& src) noexcept {
+	static_assert(simd_detail::kSupported<T>);
+	assert(dst.Size() == src.Size());
+	constexpr size_t alignment = std::min(Vector<T, A1, G1>::kGuaranteedAlignment, Vector<T, A2, G2>::kGuaranteedAlignment);
+	simd_detail::Dispatch<simd_detail::ElementwiseKernel<simd_detail::MultiplyOp>, alignment>(dst.Data(), src.Data(), dst.Size());
+}
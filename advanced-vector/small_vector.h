@@ -0,0 +1,399 @@
+#pragma once
+
+#include "vector.h"
+
+// Vector with room for N elements inside the object itself. The heap is touched only
+// when the size grows past N, after that the elements live in a RawMemory buffer
+// exactly as in Vector, grown by GrowthPolicy. Exception guarantees match the corresponding
+// Vector methods.
+template<typename T, size_t N, typename GrowthPolicy = DoublingGrowth>
+class SmallVector {
+	static_assert(N > 0, "SmallVector needs room for at least one inline element");
+
+public:
+	using value_type = T;
+
+	using iterator = T*;
+
+	using const_iterator = const T*;
+
+	SmallVector() noexcept = default;
+
+	explicit SmallVector(size_t size);
+
+	SmallVector(const SmallVector& other);
+
+	SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+	~SmallVector();
+
+	SmallVector& operator=(const SmallVector& rhs);
+
+	SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+	iterator begin() noexcept;
+
+	iterator end() noexcept;
+
+	const_iterator cbegin() const noexcept;
+
+	const_iterator cend() const noexcept;
+
+	const_iterator begin() const noexcept;
+
+	const_iterator end() const noexcept;
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	// True while the elements are stored inside the object
+	bool IsInline() const noexcept;
+
+	void Swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+	void Reserve(size_t new_capacity);
+
+	void Resize(size_t new_size);
+
+	template<typename... Args>
+	T& EmplaceBack(Args &&... args);
+
+	template<typename... Args>
+	iterator Emplace(const_iterator pos, Args &&... args);
+
+	iterator Erase(const_iterator pos);
+
+	iterator Insert(const_iterator pos, const T& item);
+
+	iterator Insert(const_iterator pos, T&& item);
+
+	T& PushBack(const T& value);
+
+	T& PushBack(T&& value);
+
+	void PopBack() noexcept;
+
+	const T& operator[](size_t index) const noexcept;
+	T& operator[](size_t index) noexcept;
+
+private:
+	alignas(T) unsigned char inline_[N * sizeof(T)];
+
+	RawMemory<T> heap_;
+
+	size_t size_ = 0;
+
+	T* Data() noexcept;
+
+	const T* Data() const noexcept;
+
+	T* InlineData() noexcept;
+
+	// Takes over the elements of other, leaving it empty
+	void StealElements(SmallVector& other);
+
+	template<typename... Args>
+	iterator EmplaceWithReallocate(size_t index, Args &&... args);
+
+	template<typename... Args>
+	iterator EmplaceWithoutReallocate(size_t index, Args &&... args);
+};
+
+template<typename T, size_t N, typename GrowthPolicy>
+SmallVector<T, N, GrowthPolicy>::SmallVector(size_t size) {
+	Reserve(size);
+	std::uninitialized_value_construct_n(Data(), size);
+	size_ = size;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+SmallVector<T, N, GrowthPolicy>::SmallVector(const SmallVector& other) {
+	Reserve(other.size_);
+	std::uninitialized_copy_n(other.Data(), other.size_, Data());
+	size_ = other.size_;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+SmallVector<T, N, GrowthPolicy>::SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+	StealElements(other);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+SmallVector<T, N, GrowthPolicy>::~SmallVector() {
+	std::destroy_n(Data(), size_);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+SmallVector<T, N, GrowthPolicy>& SmallVector<T, N, GrowthPolicy>::operator=(const SmallVector& rhs) {
+	if (this != &rhs) {
+		if (rhs.size_ > Capacity()) {
+			RawMemory<T> new_data(rhs.size_);
+			std::uninitialized_copy_n(rhs.Data(), rhs.size_, new_data.GetAddress());
+			std::destroy_n(Data(), size_);
+			heap_.Swap(new_data);
+		}
+		else {
+			size_t copy_elem = rhs.size_ < size_ ? rhs.size_ : size_;
+			auto end = std::copy_n(rhs.Data(), copy_elem, Data());
+			if (rhs.size_ < size_) {
+				std::destroy_n(end, size_ - rhs.size_);
+			}
+			else {
+				std::uninitialized_copy_n(rhs.Data() + size_, rhs.size_ - size_, end);
+			}
+		}
+		size_ = rhs.size_;
+	}
+	return *this;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+SmallVector<T, N, GrowthPolicy>& SmallVector<T, N, GrowthPolicy>::operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>) {
+	if (this != &rhs) {
+		std::destroy_n(Data(), size_);
+		size_ = 0;
+		heap_ = RawMemory<T>();
+		StealElements(rhs);
+	}
+	return *this;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::iterator SmallVector<T, N, GrowthPolicy>::begin() noexcept {
+	return Data();
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::iterator SmallVector<T, N, GrowthPolicy>::end() noexcept {
+	return Data() + size_;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::const_iterator SmallVector<T, N, GrowthPolicy>::begin() const noexcept {
+	return Data();
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::const_iterator SmallVector<T, N, GrowthPolicy>::end() const noexcept {
+	return Data() + size_;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::const_iterator SmallVector<T, N, GrowthPolicy>::cbegin() const noexcept {
+	return Data();
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::const_iterator SmallVector<T, N, GrowthPolicy>::cend() const noexcept {
+	return Data() + size_;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+size_t SmallVector<T, N, GrowthPolicy>::Size() const noexcept {
+	return size_;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+size_t SmallVector<T, N, GrowthPolicy>::Capacity() const noexcept {
+	return IsInline() ? N : heap_.Capacity();
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+bool SmallVector<T, N, GrowthPolicy>::IsInline() const noexcept {
+	return heap_.Capacity() == 0;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+void SmallVector<T, N, GrowthPolicy>::Swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+	if (!IsInline() && !other.IsInline()) {
+		heap_.Swap(other.heap_);
+		std::swap(size_, other.size_);
+		return;
+	}
+	SmallVector tmp(std::move(other));
+	other = std::move(*this);
+	*this = std::move(tmp);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+void SmallVector<T, N, GrowthPolicy>::Reserve(size_t new_capacity) {
+	if (new_capacity <= Capacity()) {
+		return;
+	}
+	RawMemory<T> new_data{new_capacity};
+	SafeRelocate(Data(), size_, new_data.GetAddress());
+	heap_.Swap(new_data);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+void SmallVector<T, N, GrowthPolicy>::Resize(size_t new_size) {
+	if (new_size < size_) {
+		std::destroy_n(Data() + new_size, size_ - new_size);
+	}
+	else if (new_size > size_) {
+		Reserve(new_size);
+		std::uninitialized_value_construct_n(Data() + size_, new_size - size_);
+	}
+	size_ = new_size;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+T& SmallVector<T, N, GrowthPolicy>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+T& SmallVector<T, N, GrowthPolicy>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+void SmallVector<T, N, GrowthPolicy>::PopBack() noexcept {
+	assert(size_ > 0);
+	std::destroy_at(Data() + (size_ - 1));
+	--size_;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+template<typename... Args>
+T& SmallVector<T, N, GrowthPolicy>::EmplaceBack(Args &&... args) {
+	if (size_ == Capacity()) {
+		return *EmplaceWithReallocate(size_, std::forward<Args>(args)...);
+	}
+	new (Data() + size_) T(std::forward<Args>(args)...);
+	++size_;
+	return Data()[size_ - 1];
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+template<typename... Args>
+typename SmallVector<T, N, GrowthPolicy>::iterator SmallVector<T, N, GrowthPolicy>::Emplace(const_iterator pos, Args &&... args) {
+	auto index = static_cast<size_t>(pos - begin());
+	if (size_ == Capacity()) {
+		return EmplaceWithReallocate(index, std::forward<Args>(args)...);
+	}
+	if (index == size_) {
+		return &EmplaceBack(std::forward<Args>(args)...);
+	}
+	return EmplaceWithoutReallocate(index, std::forward<Args>(args)...);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::iterator SmallVector<T, N, GrowthPolicy>::Insert(const_iterator pos, const T& value) {
+	return Emplace(pos, value);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::iterator SmallVector<T, N, GrowthPolicy>::Insert(const_iterator pos, T&& value) {
+	return Emplace(pos, std::move(value));
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+typename SmallVector<T, N, GrowthPolicy>::iterator SmallVector<T, N, GrowthPolicy>::Erase(const_iterator pos) {
+	auto index = static_cast<size_t>(pos - begin());
+	std::move(begin() + index + 1, end(), begin() + index);
+	PopBack();
+	return begin() + index;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+const T& SmallVector<T, N, GrowthPolicy>::operator[](size_t index) const noexcept {
+	return const_cast<SmallVector&>(*this)[index];
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+T& SmallVector<T, N, GrowthPolicy>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return Data()[index];
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+T* SmallVector<T, N, GrowthPolicy>::Data() noexcept {
+	return IsInline() ? InlineData() : heap_.GetAddress();
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+const T* SmallVector<T, N, GrowthPolicy>::Data() const noexcept {
+	return const_cast<SmallVector&>(*this).Data();
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+T* SmallVector<T, N, GrowthPolicy>::InlineData() noexcept {
+	return std::launder(reinterpret_cast<T*>(inline_));
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+void SmallVector<T, N, GrowthPolicy>::StealElements(SmallVector& other) {
+	if (!other.IsInline()) {
+		heap_.Swap(other.heap_);
+	}
+	else {
+		SafeRelocate(other.InlineData(), other.size_, InlineData());
+	}
+	size_ = std::exchange(other.size_, 0);
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+template<typename... Args>
+typename SmallVector<T, N, GrowthPolicy>::iterator
+SmallVector<T, N, GrowthPolicy>::EmplaceWithReallocate(size_t index, Args &&... args) {
+	RawMemory<T> new_data{GrowthPolicy::NextCapacity(Capacity(), size_ + 1, sizeof(T))};
+	new (new_data + index) T(std::forward<Args>(args)...);
+
+	if constexpr (IsTriviallyRelocatableV<T> || std::is_nothrow_move_constructible_v<T>
+	              || !std::is_copy_constructible_v<T>) {
+		try {
+			SafeRelocate(Data(), index, new_data.GetAddress());
+		}
+		catch (...) {
+			std::destroy_at(new_data + index);
+			throw;
+		}
+		try {
+			SafeRelocate(Data() + index, size_ - index, new_data + (index + 1));
+		}
+		catch (...) {
+			// Only a throwing move of a move-only type gets here; the prefix is gone, so leave an empty vector
+			std::destroy_n(new_data.GetAddress(), index + 1);
+			std::destroy_n(Data() + index, size_ - index);
+			size_ = 0;
+			throw;
+		}
+	}
+	else {
+		// Both halves are copied before any source element is destroyed, so a throwing copy leaves *this intact
+		try {
+			std::uninitialized_copy_n(Data(), index, new_data.GetAddress());
+		}
+		catch (...) {
+			std::destroy_at(new_data + index);
+			throw;
+		}
+		try {
+			std::uninitialized_copy_n(Data() + index, size_ - index, new_data + (index + 1));
+		}
+		catch (...) {
+			std::destroy_n(new_data.GetAddress(), index + 1);
+			throw;
+		}
+		std::destroy_n(Data(), size_);
+	}
+	heap_.Swap(new_data);
+
+	++size_;
+	return begin() + index;
+}
+
+template<typename T, size_t N, typename GrowthPolicy>
+template<typename... Args>
+typename SmallVector<T, N, GrowthPolicy>::iterator
+SmallVector<T, N, GrowthPolicy>::EmplaceWithoutReallocate(size_t index, Args &&... args) {
+	T temp(std::forward<Args>(args)...);
+	new (end()) T(std::move(Data()[size_ - 1]));
+	std::move_backward(begin() + index, end() - 1, end());
+	Data()[index] = std::move(temp);
+
+	++size_;
+	return begin() + index;
+}
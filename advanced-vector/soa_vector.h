@@ -0,0 +1,365 @@
+#pragma once
+
+#include "vector.h"
+#include "column_span.h"
+
+#include <tuple>
+
+// Proxy for one row of an SoAVector. Get<I>() gives the I-th field, and the proxy supports
+// structured bindings: auto [x, y] = soa[i];
+template<bool Const, typename... Fields>
+class SoARowReference {
+	template<typename T>
+	using Ref = std::conditional_t<Const, const T&, T&>;
+
+	template<typename T>
+	using Ptr = std::conditional_t<Const, const T*, T*>;
+
+public:
+	explicit SoARowReference(Ptr<Fields>... fields) noexcept : fields_(fields...) {}
+
+	template<size_t I>
+	auto& Get() const noexcept {
+		return *std::get<I>(fields_);
+	}
+
+	template<size_t I>
+	auto& get() const noexcept {
+		return Get<I>();
+	}
+
+	std::tuple<Ref<Fields>...> Tie() const noexcept {
+		return std::apply([](auto*... fields) {return std::tuple<Ref<Fields>...>(*fields...);}, fields_);
+	}
+
+private:
+	std::tuple<Ptr<Fields>...> fields_;
+};
+
+template<bool Const, typename... Fields>
+struct std::tuple_size<SoARowReference<Const, Fields...>> : std::integral_constant<size_t, sizeof...(Fields)> {};
+
+template<size_t I, bool Const, typename... Fields>
+struct std::tuple_element<I, SoARowReference<Const, Fields...>> {
+	using type = std::conditional_t<Const, const std::tuple_element_t<I, std::tuple<Fields...>>,
+	                                std::tuple_element_t<I, std::tuple<Fields...>>>&;
+};
+
+// Structure-of-arrays container: each field type gets its own RawMemory buffer, while size,
+// capacity and growth are shared, so a loop over one field reads only that field's memory.
+// Growth follows Vector: the new row is built in the new buffers first, then the old rows are
+// relocated column by column. When every field is nothrow-movable or copyable an exception leaves
+// the container unchanged; a move-only field whose move throws gives only the basic guarantee,
+// since its rows may be left moved-from.
+template<typename GrowthPolicy, typename... Fields>
+class BasicSoAVector {
+	static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field");
+
+	using Columns = std::tuple<RawMemory<Fields>...>;
+
+public:
+	template<size_t I>
+	using FieldType = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+	using reference = SoARowReference<false, Fields...>;
+
+	using const_reference = SoARowReference<true, Fields...>;
+
+	BasicSoAVector() noexcept = default;
+
+	BasicSoAVector(const BasicSoAVector& other);
+
+	BasicSoAVector(BasicSoAVector&& other) noexcept;
+
+	~BasicSoAVector();
+
+	BasicSoAVector& operator=(const BasicSoAVector& rhs);
+
+	BasicSoAVector& operator=(BasicSoAVector&& rhs) noexcept;
+
+	size_t Size() const noexcept;
+
+	size_t Capacity() const noexcept;
+
+	void Swap(BasicSoAVector& other) noexcept;
+
+	// Unchanged on an exception unless a move-only field's move throws, which leaves the rows
+	// valid but possibly moved-from
+	void Reserve(size_t new_capacity);
+
+	void Clear() noexcept;
+
+	// Takes one constructor argument per field. On an exception from growth the guarantee is the one of Reserve
+	template<typename... Args>
+	reference EmplaceBack(Args&&... args);
+
+	void PopBack() noexcept;
+
+	template<size_t I>
+	ColumnSpan<FieldType<I>> Column() noexcept;
+
+	template<size_t I>
+	ColumnSpan<const FieldType<I>> Column() const noexcept;
+
+	reference operator[](size_t index) noexcept;
+
+	const_reference operator[](size_t index) const noexcept;
+
+private:
+	static constexpr size_t kRowSize = (sizeof(Fields) + ...);
+
+	// Fields whose relocation may throw: they are copied, or moved if they are move-only, into
+	// the new buffers before any other column is relocated
+	template<typename T>
+	static constexpr bool kRelocatesFirst = !IsTriviallyRelocatableV<T> && !std::is_nothrow_move_constructible_v<T>;
+
+	static Columns AllocateColumns(size_t capacity);
+
+	// Constructs field I and the following ones of row index, destroying the built ones on failure
+	template<size_t I, typename Arg, typename... Rest>
+	static void ConstructFields(Columns& columns, size_t index, Arg&& arg, Rest&&... rest);
+
+	// Copy-constructs the first size elements of every column, destroying the copies made so far on failure
+	template<size_t I = 0>
+	static void CopyColumns(const Columns& from, size_t size, Columns& to);
+
+	// Copies or moves the first size elements of the kRelocatesFirst columns, destroying the
+	// elements constructed so far on failure. The sources stay alive
+	template<size_t I = 0>
+	static void TransferThrowingColumns(Columns& from, size_t size, Columns& to);
+
+	// Moves all rows to new buffers. Columns whose relocation may throw go first, and their sources
+	// are destroyed only after all of them have succeeded, so a failure leaves every row in place
+	static void RelocateColumns(Columns& from, size_t size, Columns& to);
+
+	template<size_t... I>
+	static void DestroyRows(Columns& columns, size_t begin, size_t end, std::index_sequence<I...>) noexcept;
+
+	static void SwapColumns(Columns& lhs, Columns& rhs) noexcept;
+
+	Columns columns_;
+
+	size_t size_ = 0;
+};
+
+template<typename... Fields>
+using SoAVector = BasicSoAVector<DoublingGrowth, Fields...>;
+
+template<typename GrowthPolicy, typename... Fields>
+BasicSoAVector<GrowthPolicy, Fields...>::BasicSoAVector(const BasicSoAVector& other)
+	: columns_(AllocateColumns(other.size_))
+{
+	CopyColumns(other.columns_, other.size_, columns_);
+	size_ = other.size_;
+}
+
+template<typename GrowthPolicy, typename... Fields>
+BasicSoAVector<GrowthPolicy, Fields...>::BasicSoAVector(BasicSoAVector&& other) noexcept
+	: columns_(std::move(other.columns_)), size_(std::exchange(other.size_, 0))
+{
+}
+
+template<typename GrowthPolicy, typename... Fields>
+BasicSoAVector<GrowthPolicy, Fields...>::~BasicSoAVector() {
+	Clear();
+}
+
+template<typename GrowthPolicy, typename... Fields>
+BasicSoAVector<GrowthPolicy, Fields...>& BasicSoAVector<GrowthPolicy, Fields...>::operator=(const BasicSoAVector& rhs) {
+	if (this != &rhs) {
+		BasicSoAVector copy(rhs);
+		Swap(copy);
+	}
+	return *this;
+}
+
+template<typename GrowthPolicy, typename... Fields>
+BasicSoAVector<GrowthPolicy, Fields...>& BasicSoAVector<GrowthPolicy, Fields...>::operator=(BasicSoAVector&& rhs) noexcept {
+	if (this != &rhs) {
+		BasicSoAVector moved(std::move(rhs));
+		Swap(moved);
+	}
+	return *this;
+}
+
+template<typename GrowthPolicy, typename... Fields>
+size_t BasicSoAVector<GrowthPolicy, Fields...>::Size() const noexcept {
+	return size_;
+}
+
+template<typename GrowthPolicy, typename... Fields>
+size_t BasicSoAVector<GrowthPolicy, Fields...>::Capacity() const noexcept {
+	return std::get<0>(columns_).Capacity();
+}
+
+template<typename GrowthPolicy, typename... Fields>
+void BasicSoAVector<GrowthPolicy, Fields...>::Swap(BasicSoAVector& other) noexcept {
+	SwapColumns(columns_, other.columns_);
+	std::swap(size_, other.size_);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+void BasicSoAVector<GrowthPolicy, Fields...>::Reserve(size_t new_capacity) {
+	if (new_capacity <= Capacity()) {
+		return;
+	}
+	Columns new_columns = AllocateColumns(new_capacity);
+	RelocateColumns(columns_, size_, new_columns);
+	SwapColumns(columns_, new_columns);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+void BasicSoAVector<GrowthPolicy, Fields...>::Clear() noexcept {
+	DestroyRows(columns_, 0, size_, std::index_sequence_for<Fields...>{});
+	size_ = 0;
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<typename... Args>
+typename BasicSoAVector<GrowthPolicy, Fields...>::reference BasicSoAVector<GrowthPolicy, Fields...>::EmplaceBack(Args&&... args) {
+	static_assert(sizeof...(Args) == sizeof...(Fields), "EmplaceBack takes one argument per field");
+	if (size_ == Capacity()) {
+		Columns new_columns = AllocateColumns(GrowthPolicy::NextCapacity(Capacity(), size_ + 1, kRowSize));
+		// The arguments may refer to existing rows, so they are used before the rows move
+		ConstructFields<0>(new_columns, size_, std::forward<Args>(args)...);
+		try {
+			RelocateColumns(columns_, size_, new_columns);
+		}
+		catch (...) {
+			DestroyRows(new_columns, size_, size_ + 1, std::index_sequence_for<Fields...>{});
+			throw;
+		}
+		SwapColumns(columns_, new_columns);
+	}
+	else {
+		ConstructFields<0>(columns_, size_, std::forward<Args>(args)...);
+	}
+	++size_;
+	return (*this)[size_ - 1];
+}
+
+template<typename GrowthPolicy, typename... Fields>
+void BasicSoAVector<GrowthPolicy, Fields...>::PopBack() noexcept {
+	assert(size_ > 0);
+	DestroyRows(columns_, size_ - 1, size_, std::index_sequence_for<Fields...>{});
+	--size_;
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<size_t I>
+ColumnSpan<typename BasicSoAVector<GrowthPolicy, Fields...>::template FieldType<I>> BasicSoAVector<GrowthPolicy, Fields...>::Column() noexcept {
+	return {std::get<I>(columns_).GetAddress(), size_};
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<size_t I>
+ColumnSpan<const typename BasicSoAVector<GrowthPolicy, Fields...>::template FieldType<I>> BasicSoAVector<GrowthPolicy, Fields...>::Column() const noexcept {
+	return {std::get<I>(columns_).GetAddress(), size_};
+}
+
+template<typename GrowthPolicy, typename... Fields>
+typename BasicSoAVector<GrowthPolicy, Fields...>::reference BasicSoAVector<GrowthPolicy, Fields...>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return std::apply([index](auto&... columns) {return reference(columns + index...);}, columns_);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+typename BasicSoAVector<GrowthPolicy, Fields...>::const_reference BasicSoAVector<GrowthPolicy, Fields...>::operator[](size_t index) const noexcept {
+	assert(index < size_);
+	return std::apply([index](const auto&... columns) {return const_reference(columns.GetAddress() + index...);}, columns_);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+typename BasicSoAVector<GrowthPolicy, Fields...>::Columns BasicSoAVector<GrowthPolicy, Fields...>::AllocateColumns(size_t capacity) {
+	return Columns(RawMemory<Fields>(capacity)...);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<size_t I, typename Arg, typename... Rest>
+void BasicSoAVector<GrowthPolicy, Fields...>::ConstructFields(Columns& columns, size_t index, Arg&& arg, Rest&&... rest) {
+	FieldType<I>* slot = std::get<I>(columns) + index;
+	new (slot) FieldType<I>(std::forward<Arg>(arg));
+	if constexpr (sizeof...(Rest) > 0) {
+		try {
+			ConstructFields<I + 1>(columns, index, std::forward<Rest>(rest)...);
+		}
+		catch (...) {
+			std::destroy_at(slot);
+			throw;
+		}
+	}
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<size_t I>
+void BasicSoAVector<GrowthPolicy, Fields...>::CopyColumns(const Columns& from, size_t size, Columns& to) {
+	if constexpr (I < sizeof...(Fields)) {
+		std::uninitialized_copy_n(std::get<I>(from).GetAddress(), size, std::get<I>(to).GetAddress());
+		try {
+			CopyColumns<I + 1>(from, size, to);
+		}
+		catch (...) {
+			std::destroy_n(std::get<I>(to).GetAddress(), size);
+			throw;
+		}
+	}
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<size_t I>
+void BasicSoAVector<GrowthPolicy, Fields...>::TransferThrowingColumns(Columns& from, size_t size, Columns& to) {
+	if constexpr (I < sizeof...(Fields)) {
+		using T = FieldType<I>;
+		if constexpr (kRelocatesFirst<T>) {
+			if constexpr (std::is_copy_constructible_v<T>) {
+				std::uninitialized_copy_n(std::get<I>(from).GetAddress(), size, std::get<I>(to).GetAddress());
+			}
+			else {
+				std::uninitialized_move_n(std::get<I>(from).GetAddress(), size, std::get<I>(to).GetAddress());
+			}
+		}
+		try {
+			TransferThrowingColumns<I + 1>(from, size, to);
+		}
+		catch (...) {
+			if constexpr (kRelocatesFirst<T>) {
+				std::destroy_n(std::get<I>(to).GetAddress(), size);
+			}
+			throw;
+		}
+	}
+}
+
+template<typename GrowthPolicy, typename... Fields>
+void BasicSoAVector<GrowthPolicy, Fields...>::RelocateColumns(Columns& from, size_t size, Columns& to) {
+	if constexpr ((kRelocatesFirst<Fields> || ...)) {
+		TransferThrowingColumns(from, size, to);
+	}
+	// The remaining columns relocate by memcpy or a noexcept move, so nothing below can throw
+	std::apply([&](auto&... from_columns) {
+		std::apply([&](auto&... to_columns) {
+			([&](auto& source, auto& target) {
+				using T = std::remove_pointer_t<decltype(source.GetAddress())>;
+				if constexpr (kRelocatesFirst<T>) {
+					std::destroy_n(source.GetAddress(), size);
+				}
+				else {
+					SafeRelocate(source.GetAddress(), size, target.GetAddress());
+				}
+			}(from_columns, to_columns), ...);
+		}, to);
+	}, from);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+template<size_t... I>
+void BasicSoAVector<GrowthPolicy, Fields...>::DestroyRows(Columns& columns, size_t begin, size_t end, std::index_sequence<I...>) noexcept {
+	(std::destroy(std::get<I>(columns) + begin, std::get<I>(columns) + end), ...);
+}
+
+template<typename GrowthPolicy, typename... Fields>
+void BasicSoAVector<GrowthPolicy, Fields...>::SwapColumns(Columns& lhs, Columns& rhs) noexcept {
+	std::apply([&rhs](auto&... lhs_columns) {
+		std::apply([&](auto&... rhs_columns) {(lhs_columns.Swap(rhs_columns), ...);}, rhs);
+	}, lhs);
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace static_vector_detail {
+
+	// Trivial elements live in a plain array, so every operation is usable in constant expressions
+	// and the whole container is trivially copyable
+	template<typename T, size_t N, bool Trivial = std::is_trivial_v<T>>
+	class Storage {
+	protected:
+		constexpr T* Elements() noexcept {return data_;}
+
+		constexpr const T* Elements() const noexcept {return data_;}
+
+		template<typename... Args>
+		constexpr T& Construct(size_t index, Args&&... args) {
+			data_[index] = T(std::forward<Args>(args)...);
+			return data_[index];
+		}
+
+		constexpr void Destroy(size_t /*first*/, size_t /*last*/) noexcept {}
+
+		T data_[N] = {};
+
+		size_t size_ = 0;
+	};
+
+	// Other elements are constructed in raw bytes and destroyed explicitly
+	template<typename T, size_t N>
+	class Storage<T, N, false> {
+	public:
+		Storage() noexcept {}
+
+		Storage(const Storage& other);
+
+		Storage(Storage&& other) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+		~Storage();
+
+		Storage& operator=(const Storage& rhs);
+
+		Storage& operator=(Storage&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+	protected:
+		T* Elements() noexcept {return std::launder(reinterpret_cast<T*>(bytes_));}
+
+		const T* Elements() const noexcept {return std::launder(reinterpret_cast<const T*>(bytes_));}
+
+		template<typename... Args>
+		T& Construct(size_t index, Args&&... args) {
+			return *new (Elements() + index) T(std::forward<Args>(args)...);
+		}
+
+		void Destroy(size_t first, size_t last) noexcept {
+			std::destroy(Elements() + first, Elements() + last);
+		}
+
+		alignas(T) unsigned char bytes_[sizeof(T) * N];
+
+		size_t size_ = 0;
+	};
+
+	template<typename T, size_t N>
+	Storage<T, N, false>::Storage(const Storage& other) {
+		std::uninitialized_copy_n(other.Elements(), other.size_, Elements());
+		size_ = other.size_;
+	}
+
+	template<typename T, size_t N>
+	Storage<T, N, false>::Storage(Storage&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+		std::uninitialized_move_n(other.Elements(), other.size_, Elements());
+		size_ = other.size_;
+	}
+
+	template<typename T, size_t N>
+	Storage<T, N, false>::~Storage() {
+		Destroy(0, size_);
+	}
+
+	template<typename T, size_t N>
+	Storage<T, N, false>& Storage<T, N, false>::operator=(const Storage& rhs) {
+		if (this != &rhs) {
+			size_t common = std::min(size_, rhs.size_);
+			std::copy_n(rhs.Elements(), common, Elements());
+			if (rhs.size_ < size_) {
+				Destroy(rhs.size_, size_);
+			}
+			else {
+				std::uninitialized_copy(rhs.Elements() + common, rhs.Elements() + rhs.size_, Elements() + common);
+			}
+			size_ = rhs.size_;
+		}
+		return *this;
+	}
+
+	template<typename T, size_t N>
+	Storage<T, N, false>& Storage<T, N, false>::operator=(Storage&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>) {
+		if (this != &rhs) {
+			size_t common = std::min(size_, rhs.size_);
+			std::move(rhs.Elements(), rhs.Elements() + common, Elements());
+			if (rhs.size_ < size_) {
+				Destroy(rhs.size_, size_);
+			}
+			else {
+				std::uninitialized_move(rhs.Elements() + common, rhs.Elements() + rhs.size_, Elements() + common);
+			}
+			size_ = rhs.size_;
+		}
+		return *this;
+	}
+
+}//end namespace static_vector_detail
+
+// Vector with a fixed capacity of N elements stored inside the object; it never allocates.
+// Growing past N throws std::length_error. For trivial element types (integers, enums, plain
+// structs, std::string_view-like pairs of pointers) every member is constexpr, so lookup tables
+// can be filled with PushBack inside a constexpr function and built at compile time:
+//
+//	constexpr auto kSquares = [] {
+//		StaticVector<int, 16> table;
+//		for (int i = 0; i < 16; ++i) {
+//			table.PushBack(i * i);
+//		}
+//		return table;
+//	}();
+//
+// Other element types are constructed in uninitialized inline storage, with the exception
+// guarantees of the corresponding Vector methods.
+template<typename T, size_t N>
+class StaticVector : private static_vector_detail::Storage<T, N> {
+	static_assert(N > 0, "StaticVector needs room for at least one element");
+
+	using Base = static_vector_detail::Storage<T, N>;
+
+public:
+	using value_type = T;
+
+	using iterator = T*;
+
+	using const_iterator = const T*;
+
+	StaticVector() noexcept = default;
+
+	constexpr explicit StaticVector(size_t size);
+
+	constexpr iterator begin() noexcept;
+
+	constexpr iterator end() noexcept;
+
+	constexpr const_iterator begin() const noexcept;
+
+	constexpr const_iterator end() const noexcept;
+
+	constexpr const_iterator cbegin() const noexcept;
+
+	constexpr const_iterator cend() const noexcept;
+
+	constexpr T* Data() noexcept;
+
+	constexpr const T* Data() const noexcept;
+
+	constexpr size_t Size() const noexcept;
+
+	static constexpr size_t Capacity() noexcept;
+
+	constexpr bool Full() const noexcept;
+
+	constexpr void Clear() noexcept;
+
+	constexpr void Resize(size_t new_size);
+
+	template<typename... Args>
+	constexpr T& EmplaceBack(Args&&... args);
+
+	constexpr T& PushBack(const T& value);
+
+	constexpr T& PushBack(T&& value);
+
+	constexpr void PopBack() noexcept;
+
+	constexpr iterator Erase(const_iterator pos);
+
+	constexpr const T& operator[](size_t index) const noexcept;
+
+	constexpr T& operator[](size_t index) noexcept;
+
+private:
+	using Base::size_;
+
+	constexpr void CheckRoom(size_t new_size) const;
+};
+
+template<typename T, size_t N>
+constexpr StaticVector<T, N>::StaticVector(size_t size) {
+	Resize(size);
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::iterator StaticVector<T, N>::begin() noexcept {
+	return this->Elements();
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::iterator StaticVector<T, N>::end() noexcept {
+	return this->Elements() + size_;
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::const_iterator StaticVector<T, N>::begin() const noexcept {
+	return this->Elements();
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::const_iterator StaticVector<T, N>::end() const noexcept {
+	return this->Elements() + size_;
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::const_iterator StaticVector<T, N>::cbegin() const noexcept {
+	return begin();
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::const_iterator StaticVector<T, N>::cend() const noexcept {
+	return end();
+}
+
+template<typename T, size_t N>
+constexpr T* StaticVector<T, N>::Data() noexcept {
+	return this->Elements();
+}
+
+template<typename T, size_t N>
+constexpr const T* StaticVector<T, N>::Data() const noexcept {
+	return this->Elements();
+}
+
+template<typename T, size_t N>
+constexpr size_t StaticVector<T, N>::Size() const noexcept {
+	return size_;
+}
+
+template<typename T, size_t N>
+constexpr size_t StaticVector<T, N>::Capacity() noexcept {
+	return N;
+}
+
+template<typename T, size_t N>
+constexpr bool StaticVector<T, N>::Full() const noexcept {
+	return size_ == N;
+}
+
+template<typename T, size_t N>
+constexpr void StaticVector<T, N>::Clear() noexcept {
+	this->Destroy(0, size_);
+	size_ = 0;
+}
+
+template<typename T, size_t N>
+constexpr void StaticVector<T, N>::Resize(size_t new_size) {
+	CheckRoom(new_size);
+	if (new_size < size_) {
+		this->Destroy(new_size, size_);
+		size_ = new_size;
+	}
+	while (size_ < new_size) {
+		EmplaceBack();
+	}
+}
+
+template<typename T, size_t N>
+template<typename... Args>
+constexpr T& StaticVector<T, N>::EmplaceBack(Args&&... args) {
+	CheckRoom(size_ + 1);
+	T& value = this->Construct(size_, std::forward<Args>(args)...);
+	++size_;
+	return value;
+}
+
+template<typename T, size_t N>
+constexpr T& StaticVector<T, N>::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, size_t N>
+constexpr T& StaticVector<T, N>::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, size_t N>
+constexpr void StaticVector<T, N>::PopBack() noexcept {
+	assert(size_ > 0);
+	this->Destroy(size_ - 1, size_);
+	--size_;
+}
+
+template<typename T, size_t N>
+constexpr typename StaticVector<T, N>::iterator StaticVector<T, N>::Erase(const_iterator pos) {
+	assert(pos >= begin() && pos < end());
+	auto index = static_cast<size_t>(pos - begin());
+	for (size_t i = index; i + 1 < size_; ++i) {
+		(*this)[i] = std::move((*this)[i + 1]);
+	}
+	PopBack();
+	return begin() + index;
+}
+
+template<typename T, size_t N>
+constexpr const T& StaticVector<T, N>::operator[](size_t index) const noexcept {
+	assert(index < size_);
+	return this->Elements()[index];
+}
+
+template<typename T, size_t N>
+constexpr T& StaticVector<T, N>::operator[](size_t index) noexcept {
+	assert(index < size_);
+	return this->Elements()[index];
+}
+
+template<typename T, size_t N>
+constexpr void StaticVector<T, N>::CheckRoom(size_t new_size) const {
+	if (new_size > N) {
+		throw std::length_error("StaticVector capacity exceeded");
+	}
+}
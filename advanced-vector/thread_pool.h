@@ -0,0 +1,232 @@
+#pragma once
+
+#include "vector.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Work-stealing thread pool behind the parallel algorithms. Every worker owns a task queue: it
+// takes work from the back of its own queue and, when that is empty, steals from the front of
+// the others, so uneven chunks do not leave threads idle. A thread waiting in ParallelFor runs
+// queued tasks itself, which keeps nested parallel calls from deadlocking.
+class ThreadPool {
+public:
+	// A pool without workers is valid: ParallelFor then runs everything on the calling thread
+	explicit ThreadPool(size_t workers = DefaultWorkerCount());
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool();
+
+	// Shared pool with one worker per hardware thread besides the caller
+	static ThreadPool& Default();
+
+	static size_t DefaultWorkerCount() noexcept;
+
+	size_t WorkerCount() const noexcept;
+
+	// Calls fn(begin, end) for consecutive ranges of at most grain indices covering [0, count) and
+	// waits for all of them. If some calls throw, the first exception is rethrown after the rest
+	// have finished; the pool itself never drops a range
+	template<typename F>
+	void ParallelFor(size_t count, size_t grain, F&& fn);
+
+private:
+	using Task = std::function<void()>;
+
+	struct Queue {
+		std::mutex mutex;
+
+		std::deque<Task> tasks;
+	};
+
+	void Push(size_t queue, Task task);
+
+	bool TryRunOne(size_t self);
+
+	void WorkerLoop(size_t self);
+
+	void Stop() noexcept;
+
+	std::unique_ptr<Queue[]> queues_;
+
+	size_t queue_count_;
+
+	Vector<std::thread> workers_;
+
+	std::atomic<size_t> pending_{0};
+
+	std::mutex wake_mutex_;
+
+	std::condition_variable wake_;
+
+	bool stop_ = false;
+};
+
+inline ThreadPool::ThreadPool(size_t workers)
+	: queues_(std::make_unique<Queue[]>(workers + 1))
+	, queue_count_(workers + 1)
+{
+	// The last queue belongs to threads outside the pool that call ParallelFor
+	workers_.Reserve(workers);
+	try {
+		for (size_t i = 0; i < workers; ++i) {
+			workers_.EmplaceBack([this, i] {WorkerLoop(i);});
+		}
+	}
+	catch (...) {
+		Stop();
+		throw;
+	}
+}
+
+inline ThreadPool::~ThreadPool() {
+	Stop();
+}
+
+inline ThreadPool& ThreadPool::Default() {
+	static ThreadPool pool;
+	return pool;
+}
+
+inline size_t ThreadPool::DefaultWorkerCount() noexcept {
+	unsigned threads = std::thread::hardware_concurrency();
+	return threads > 1 ? threads - 1 : 0;
+}
+
+inline size_t ThreadPool::WorkerCount() const noexcept {
+	return workers_.Size();
+}
+
+template<typename F>
+void ThreadPool::ParallelFor(size_t count, size_t grain, F&& fn) {
+	if (grain == 0) {
+		grain = 1;
+	}
+	size_t chunks = (count + grain - 1) / grain;
+	if (chunks <= 1 || workers_.Size() == 0) {
+		for (size_t begin = 0; begin < count; begin += grain) {
+			fn(begin, std::min(begin + grain, count));
+		}
+		return;
+	}
+
+	struct State {
+		size_t remaining;
+
+		std::mutex mutex;
+
+		std::condition_variable done;
+
+		std::exception_ptr error;
+	} state;
+	state.remaining = chunks;
+
+	auto run_chunk = [&state, &fn](size_t begin, size_t end) {
+		try {
+			fn(begin, end);
+		}
+		catch (...) {
+			std::lock_guard lock(state.mutex);
+			if (!state.error) {
+				state.error = std::current_exception();
+			}
+		}
+		// Under the lock so that state outlives the last access to it
+		std::lock_guard lock(state.mutex);
+		if (--state.remaining == 0) {
+			state.done.notify_all();
+		}
+	};
+	for (size_t chunk = 0; chunk < chunks; ++chunk) {
+		size_t begin = chunk * grain;
+		size_t end = std::min(begin + grain, count);
+		try {
+			Push(chunk % queue_count_, [&run_chunk, begin, end] {run_chunk(begin, end);});
+		}
+		catch (...) {
+			// Out of memory for the task queue: run the chunk here rather than lose it
+			run_chunk(begin, end);
+		}
+	}
+
+	// Help instead of blocking while there is anything left to run
+	while (TryRunOne(queue_count_ - 1)) {
+	}
+	std::unique_lock lock(state.mutex);
+	state.done.wait(lock, [&state] {return state.remaining == 0;});
+	if (state.error) {
+		std::rethrow_exception(state.error);
+	}
+}
+
+inline void ThreadPool::Push(size_t queue, Task task) {
+	{
+		std::lock_guard lock(queues_[queue].mutex);
+		queues_[queue].tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard lock(wake_mutex_);
+		pending_.fetch_add(1, std::memory_order_release);
+	}
+	wake_.notify_one();
+}
+
+inline bool ThreadPool::TryRunOne(size_t self) {
+	Task task;
+	for (size_t i = 0; i < queue_count_ && !task; ++i) {
+		size_t victim = (self + i) % queue_count_;
+		std::lock_guard lock(queues_[victim].mutex);
+		auto& tasks = queues_[victim].tasks;
+		if (tasks.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			task = std::move(tasks.back());
+			tasks.pop_back();
+		}
+		else {
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+	}
+	if (!task) {
+		return false;
+	}
+	pending_.fetch_sub(1, std::memory_order_acq_rel);
+	task();
+	return true;
+}
+
+inline void ThreadPool::WorkerLoop(size_t self) {
+	for (;;) {
+		if (TryRunOne(self)) {
+			continue;
+		}
+		std::unique_lock lock(wake_mutex_);
+		wake_.wait(lock, [this] {return stop_ || pending_.load(std::memory_order_acquire) != 0;});
+		if (stop_) {
+			return;
+		}
+	}
+}
+
+inline void ThreadPool::Stop() noexcept {
+	{
+		std::lock_guard lock(wake_mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+	workers_.Clear();
+}
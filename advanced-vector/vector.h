@@ -1,271 +1,964 @@
 #pragma once
 
 #include <new>
+#include <atomic>
 #include <memory>
 #include <utility>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iterator>
-#include <iostream>
+#include <ostream>
 #include <algorithm>
+#include <memory_resource>
+#include <type_traits>
+
+#include "vector_stats.h"
+
+// Marks the reallocating branches so they stay out of line and the in-capacity path of
+// EmplaceBack inlines into a compare, a construction and an increment
+#if defined(__GNUC__) || defined(__clang__)
+#define ADVANCED_VECTOR_COLD __attribute__((noinline, cold))
+#define ADVANCED_VECTOR_UNLIKELY(condition) __builtin_expect(!!(condition), 0)
+#elif defined(_MSC_VER)
+#define ADVANCED_VECTOR_COLD __declspec(noinline)
+#define ADVANCED_VECTOR_UNLIKELY(condition) (condition)
+#else
+#define ADVANCED_VECTOR_COLD
+#define ADVANCED_VECTOR_UNLIKELY(condition) (condition)
+#endif
+
+// Under C++20 the basic Vector paths (construction, copying, element access, Reserve, Resize,
+// EmplaceBack, PopBack, Erase) are constexpr, so a Vector with std::allocator can be used inside
+// constant expressions as long as it is destroyed before the evaluation ends
+#if __cplusplus >= 202002L
+#define ADVANCED_VECTOR_CONSTEXPR20 constexpr
+#else
+#define ADVANCED_VECTOR_CONSTEXPR20
+#endif
+
+namespace vector_detail {
+
+	// True while a constant expression is evaluated. memcpy, the bulk executor and the
+	// uninitialized memory algorithms are not allowed there and are replaced by element loops
+	constexpr bool IsConstantEvaluated() noexcept {
+#if __cplusplus >= 202002L
+		return std::is_constant_evaluated();
+#else
+		return false;
+#endif
+	}
+
+	template<typename T, typename... Args>
+	ADVANCED_VECTOR_CONSTEXPR20 T* ConstructAt(T* to, Args&&... args) {
+#if __cplusplus >= 202002L
+		return std::construct_at(to, std::forward<Args>(args)...);
+#else
+		return new (static_cast<void*>(to)) T(std::forward<Args>(args)...);
+#endif
+	}
+
+	// std::uninitialized_value_construct_n, also usable in constant expressions, where nothing can throw
+	template<typename T>
+	ADVANCED_VECTOR_CONSTEXPR20 void UninitializedValueConstructN(T* to, size_t size) {
+		if (IsConstantEvaluated()) {
+			for (size_t i = 0; i < size; ++i) {
+				ConstructAt(to + i);
+			}
+			return;
+		}
+		std::uninitialized_value_construct_n(to, size);
+	}
+
+	// std::uninitialized_copy_n, also usable in constant expressions
+	template<typename InputIt, typename T>
+	ADVANCED_VECTOR_CONSTEXPR20 void UninitializedCopyN(InputIt from, size_t size, T* to) {
+		if (IsConstantEvaluated()) {
+			for (size_t i = 0; i < size; ++i, ++from) {
+				ConstructAt(to + i, *from);
+			}
+			return;
+		}
+		std::uninitialized_copy_n(from, size, to);
+	}
+
+}//end namespace vector_detail
+
+// Types whose objects can be moved to a new address with memcpy, leaving the
+// old bytes for dead without running the destructor. Trivially copyable types
+// are detected automatically; other types opt in by specializing the trait:
+//
+//	template<>
+//	struct IsTriviallyRelocatable<MyType> : std::true_type {};
+template<typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template<typename T>
+inline constexpr bool IsTriviallyRelocatableV = IsTriviallyRelocatable<T>::value;
+
+// Moves size objects from one uninitialized buffer to another and ends their lifetime in the source.
+// Elements are copied when their move constructor may throw and a copy constructor exists,
+// so that an exception leaves the source untouched.
+template<typename T>
+ADVANCED_VECTOR_CONSTEXPR20 void SafeRelocate(T* from, size_t size, T* to) {
+	if (vector_detail::IsConstantEvaluated()) {
+		for (size_t i = 0; i < size; ++i) {
+			vector_detail::ConstructAt(to + i, std::move_if_noexcept(from[i]));
+		}
+		std::destroy_n(from, size);
+		return;
+	}
+	if constexpr (IsTriviallyRelocatableV<T>) {
+		// The bytes at from are dead after the copy, so no destructors run
+		if (size != 0) {
+			std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), size * sizeof(T));
+		}
+	}
+	else if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+		std::uninitialized_move_n(from, size, to);
+		std::destroy_n(from, size);
+	}
+	else {
+		std::uninitialized_copy_n(from, size, to);
+		std::destroy_n(from, size);
+	}
+}
+
+// Opt-in multi-threaded execution of the bulk element loops of Vector: value construction,
+// copying, relocation to a new buffer and destruction. Until an executor is enabled the loops
+// run serially and cost one comparison against the threshold. With an executor (see
+// EnableParallelBulkOperations in parallel.h) loops over at least threshold_bytes are split into
+// chunks run by several threads, which also spreads the first touch of fresh pages over them.
+// If constructing a chunk throws, the fully constructed chunks are destroyed before the
+// exception propagates, as in the serial loops.
+class BulkExecutor {
+public:
+	using ChunkFunction = void (*)(void* context, size_t begin, size_t end);
+
+	virtual ~BulkExecutor() = default;
+
+	// Elements per chunk for a loop over count elements of element_size bytes
+	virtual size_t Grain(size_t count, size_t element_size) const noexcept = 0;
+
+	// Calls fn(context, begin, end) for consecutive ranges of grain indices covering [0, count) and
+	// waits for all of them. Exceptions from fn are rethrown after every range has been processed
+	virtual void Run(size_t count, size_t grain, void* context, ChunkFunction fn) = 0;
+};
+
+class BulkExecution {
+public:
+	// The executor must outlive every Vector operation that may use it
+	static void Enable(BulkExecutor& executor, size_t threshold_bytes) noexcept;
+
+	static void Disable() noexcept;
+
+	// The executor for a loop over bytes bytes, or nullptr to run it serially
+	static BulkExecutor* For(size_t bytes) noexcept;
+
+	// The loops below run serially in constant expressions
+	template<typename T>
+	static ADVANCED_VECTOR_CONSTEXPR20 void ValueConstruct(T* to, size_t size);
+
+	template<typename T>
+	static ADVANCED_VECTOR_CONSTEXPR20 void Copy(const T* from, size_t size, T* to);
+
+	// Same contract as SafeRelocate
+	template<typename T>
+	static ADVANCED_VECTOR_CONSTEXPR20 void Relocate(T* from, size_t size, T* to);
+
+	template<typename T>
+	static ADVANCED_VECTOR_CONSTEXPR20 void Destroy(T* data, size_t size) noexcept;
+
+private:
+	template<typename F>
+	static void Run(BulkExecutor& executor, size_t count, size_t grain, F& fn);
+
+	// Runs construct(begin, end) over the chunks; on failure destroys the chunks that succeeded
+	template<typename T, typename F>
+	static void ConstructChunks(BulkExecutor& executor, T* to, size_t size, F construct);
+
+	static inline std::atomic<BulkExecutor*> executor_{nullptr};
+
+	static inline std::atomic<size_t> threshold_{SIZE_MAX};
+};
+
+inline void BulkExecution::Enable(BulkExecutor& executor, size_t threshold_bytes) noexcept {
+	executor_.store(&executor, std::memory_order_release);
+	threshold_.store(threshold_bytes, std::memory_order_release);
+}
+
+inline void BulkExecution::Disable() noexcept {
+	threshold_.store(SIZE_MAX, std::memory_order_release);
+	executor_.store(nullptr, std::memory_order_release);
+}
+
+inline BulkExecutor* BulkExecution::For(size_t bytes) noexcept {
+	if (bytes < threshold_.load(std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	return executor_.load(std::memory_order_acquire);
+}
+
+template<typename T>
+ADVANCED_VECTOR_CONSTEXPR20 void BulkExecution::ValueConstruct(T* to, size_t size) {
+	BulkExecutor* executor = vector_detail::IsConstantEvaluated() ? nullptr : For(size * sizeof(T));
+	if (executor == nullptr) {
+		vector_detail::UninitializedValueConstructN(to, size);
+		return;
+	}
+	ConstructChunks(*executor, to, size, [to](size_t begin, size_t end) {
+		std::uninitialized_value_construct_n(to + begin, end - begin);
+	});
+}
 
 template<typename T>
-class RawMemory {
+ADVANCED_VECTOR_CONSTEXPR20 void BulkExecution::Copy(const T* from, size_t size, T* to) {
+	BulkExecutor* executor = vector_detail::IsConstantEvaluated() ? nullptr : For(size * sizeof(T));
+	if (executor == nullptr) {
+		vector_detail::UninitializedCopyN(from, size, to);
+		return;
+	}
+	ConstructChunks(*executor, to, size, [from, to](size_t begin, size_t end) {
+		std::uninitialized_copy_n(from + begin, end - begin, to + begin);
+	});
+}
+
+template<typename T>
+ADVANCED_VECTOR_CONSTEXPR20 void BulkExecution::Relocate(T* from, size_t size, T* to) {
+	BulkExecutor* executor = vector_detail::IsConstantEvaluated() ? nullptr : For(size * sizeof(T));
+	if (executor == nullptr) {
+		SafeRelocate(from, size, to);
+		return;
+	}
+	size_t grain = executor->Grain(size, sizeof(T));
+	if constexpr (IsTriviallyRelocatableV<T>) {
+		auto copy = [from, to](size_t begin, size_t end) {
+			std::memcpy(static_cast<void*>(to + begin), static_cast<const void*>(from + begin), (end - begin) * sizeof(T));
+		};
+		Run(*executor, size, grain, copy);
+	}
+	else if constexpr (std::is_nothrow_move_constructible_v<T>) {
+		auto move = [from, to](size_t begin, size_t end) {
+			std::uninitialized_move_n(from + begin, end - begin, to + begin);
+			std::destroy_n(from + begin, end - begin);
+		};
+		Run(*executor, size, grain, move);
+	}
+	else if constexpr (!std::is_copy_constructible_v<T>) {
+		// Chunks that finished before a throwing move would have destroyed their sources already
+		SafeRelocate(from, size, to);
+	}
+	else {
+		// The source is destroyed only once every copy has succeeded
+		Copy(static_cast<const T*>(from), size, to);
+		Destroy(from, size);
+	}
+}
+
+template<typename T>
+ADVANCED_VECTOR_CONSTEXPR20 void BulkExecution::Destroy(T* data, size_t size) noexcept {
+	if constexpr (!std::is_trivially_destructible_v<T>) {
+		BulkExecutor* executor = vector_detail::IsConstantEvaluated() ? nullptr : For(size * sizeof(T));
+		if (executor == nullptr) {
+			std::destroy_n(data, size);
+			return;
+		}
+		auto destroy = [data](size_t begin, size_t end) {
+			std::destroy_n(data + begin, end - begin);
+		};
+		Run(*executor, size, executor->Grain(size, sizeof(T)), destroy);
+	}
+}
+
+template<typename F>
+void BulkExecution::Run(BulkExecutor& executor, size_t count, size_t grain, F& fn) {
+	executor.Run(count, grain, &fn, [](void* context, size_t begin, size_t end) {
+		(*static_cast<F*>(context))(begin, end);
+	});
+}
+
+template<typename T, typename F>
+void BulkExecution::ConstructChunks(BulkExecutor& executor, T* to, size_t size, F construct) {
+	size_t grain = executor.Grain(size, sizeof(T));
+	size_t chunks = (size + grain - 1) / grain;
+	// Each chunk writes only its own flag, and Run returns after all chunks have finished
+	std::unique_ptr<bool[]> constructed(new bool[chunks]());
+	auto chunk = [&](size_t begin, size_t end) {
+		// A failing chunk destroys its own elements, so only finished chunks are marked
+		construct(begin, end);
+		constructed[begin / grain] = true;
+	};
+	try {
+		Run(executor, size, grain, chunk);
+	}
+	catch (...) {
+		for (size_t i = 0; i < chunks; ++i) {
+			if (constructed[i]) {
+				size_t begin = i * grain;
+				std::destroy_n(to + begin, std::min(grain, size - begin));
+			}
+		}
+		throw;
+	}
+}
+
+// Allocators may offer T* reallocate(T* buf, size_t old_n, size_t new_n) noexcept that resizes
+// a block keeping its bytes (possibly at a new address) and returns nullptr on failure
+template<typename Allocator, typename = void>
+struct HasReallocate : std::false_type {};
+
+template<typename Allocator>
+struct HasReallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().reallocate(
+	std::declval<typename Allocator::value_type*>(), size_t{}, size_t{}))>> : std::true_type {};
+
+// Alignment every buffer from the allocator is guaranteed to have. Allocators with a stronger
+// guarantee than alignof(T) declare it as static constexpr size_t alignment
+template<typename Allocator, typename = void>
+struct AllocatorAlignment : std::integral_constant<size_t, alignof(typename Allocator::value_type)> {};
+
+template<typename Allocator>
+struct AllocatorAlignment<Allocator, std::void_t<decltype(Allocator::alignment)>>
+	: std::integral_constant<size_t, Allocator::alignment> {};
+
+// Uninitialized storage for capacity objects of type T, obtained from an
+// std::allocator-compatible Allocator. The allocator is kept as an empty base
+// so that stateless allocators add nothing to the object size.
+template<typename T, typename Allocator = std::allocator<T>>
+class RawMemory : private Allocator {
+	using AllocTraits = std::allocator_traits<Allocator>;
+
+	static_assert(std::is_same_v<typename AllocTraits::value_type, T>, "Allocator::value_type must be T");
+
 public:
-	RawMemory() noexcept = default;
+	using allocator_type = Allocator;
+
+	RawMemory() noexcept(std::is_nothrow_default_constructible_v<Allocator>) = default;
 
-	explicit RawMemory(size_t capacity) : buffer_(Allocate(capacity)), capacity_(capacity) {}
+	ADVANCED_VECTOR_CONSTEXPR20 explicit RawMemory(const Allocator& alloc) noexcept : Allocator(alloc) {}
+
+	ADVANCED_VECTOR_CONSTEXPR20 explicit RawMemory(size_t capacity, const Allocator& alloc = Allocator())
+		: Allocator(alloc), buffer_(Allocate(capacity)), capacity_(capacity) {}
 
 	RawMemory(const RawMemory&) = delete;
 
-	RawMemory(RawMemory&& other) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 RawMemory(RawMemory&& other) noexcept;
 
-	~RawMemory();
+	ADVANCED_VECTOR_CONSTEXPR20 ~RawMemory();
 
 	RawMemory& operator=(const RawMemory& rhs) = delete;
 
-	RawMemory& operator=(RawMemory&& rhs) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 RawMemory& operator=(RawMemory&& rhs) noexcept;
 
-	T* operator+(size_t offset) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 T* operator+(size_t offset) noexcept;
 
-	const T* operator+(size_t offset) const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const T* operator+(size_t offset) const noexcept;
 
-	T& operator[](size_t index) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 T& operator[](size_t index) noexcept;
 
-	const T& operator[](size_t index) const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const T& operator[](size_t index) const noexcept;
 
-	void Swap(RawMemory& other) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 void Swap(RawMemory& other) noexcept;
 
-	const T* GetAddress() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const T* GetAddress() const noexcept;
 
-	T* GetAddress() noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 T* GetAddress() noexcept;
 
-	size_t Capacity() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 size_t Capacity() const noexcept;
 
-private:
-	void Init(RawMemory&& other) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const Allocator& GetAllocator() const noexcept;
+
+	static constexpr bool kCanReallocate = HasReallocate<Allocator>::value;
 
-	static T* Allocate(size_t n);
+	// Resizes the buffer through Allocator::reallocate, keeping its bytes. Only valid when the
+	// constructed objects are trivially relocatable. On failure returns false and changes nothing
+	bool Reallocate(size_t new_capacity) noexcept;
 
-	static void Deallocate(T* buf) noexcept;
+	// Frees the buffer and adopts alloc; used when propagating an allocator on copy assignment
+	ADVANCED_VECTOR_CONSTEXPR20 void Reset(const Allocator& alloc) noexcept;
+
+private:
+	ADVANCED_VECTOR_CONSTEXPR20 T* Allocate(size_t n);
+
+	ADVANCED_VECTOR_CONSTEXPR20 void Deallocate(T* buf, size_t n) noexcept;
 
 	T* buffer_ = nullptr;
 
 	size_t capacity_ = 0;
 };
 
-template<typename T>
-RawMemory<T>::RawMemory(RawMemory&& other) noexcept {
-	Init(std::move(other));
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 RawMemory<T, Allocator>::RawMemory(RawMemory&& other) noexcept
+	: Allocator(std::move(static_cast<Allocator&>(other)))
+	, buffer_(std::exchange(other.buffer_, nullptr))
+	, capacity_(std::exchange(other.capacity_, 0))
+{
 }
 
-template<typename T>
-RawMemory<T>& RawMemory<T>::operator=(RawMemory&& rhs) noexcept {
-	Init(std::move(rhs));
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 RawMemory<T, Allocator>& RawMemory<T, Allocator>::operator=(RawMemory&& rhs) noexcept {
+	if (this != &rhs) {
+		Deallocate(buffer_, capacity_);
+		if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+			static_cast<Allocator&>(*this) = std::move(static_cast<Allocator&>(rhs));
+		}
+		else {
+			// Memory owned by an unequal allocator can not be adopted, Vector moves elements instead
+			assert(GetAllocator() == rhs.GetAllocator());
+		}
+		buffer_ = std::exchange(rhs.buffer_, nullptr);
+		capacity_ = std::exchange(rhs.capacity_, 0);
+	}
 	return *this;
 }
 
-template<typename T>
-RawMemory<T>::~RawMemory() {
-	Deallocate(buffer_);
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 RawMemory<T, Allocator>::~RawMemory() {
+	Deallocate(buffer_, capacity_);
 }
 
-template<typename T>
-T* RawMemory<T>::operator+(size_t offset) noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 T* RawMemory<T, Allocator>::operator+(size_t offset) noexcept {
 	assert(offset <= capacity_);
 	return buffer_ + offset;
 }
 
-template<typename T>
-const T* RawMemory<T>::operator+(size_t offset) const noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 const T* RawMemory<T, Allocator>::operator+(size_t offset) const noexcept {
 	return const_cast<RawMemory&>(*this) + offset;
 }
 
-template<typename T>
-const T& RawMemory<T>::operator[](size_t index) const noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 const T& RawMemory<T, Allocator>::operator[](size_t index) const noexcept {
 	return const_cast<RawMemory&>(*this)[index];
 }
 
-template<typename T>
-T& RawMemory<T>::operator[](size_t index) noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 T& RawMemory<T, Allocator>::operator[](size_t index) noexcept {
 	assert(index < capacity_);
 	return buffer_[index];
 }
 
-template<typename T>
-void RawMemory<T>::Swap(RawMemory& other) noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 void RawMemory<T, Allocator>::Swap(RawMemory& other) noexcept {
+	if constexpr (AllocTraits::propagate_on_container_swap::value) {
+		using std::swap;
+		swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
+	}
+	else {
+		assert(GetAllocator() == other.GetAllocator());
+	}
 	std::swap(buffer_, other.buffer_);
 	std::swap(capacity_, other.capacity_);
 }
 
-template<typename T>
-const T* RawMemory<T>::GetAddress() const noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 const T* RawMemory<T, Allocator>::GetAddress() const noexcept {
 	return buffer_;
 }
 
-template<typename T>
-T* RawMemory<T>::GetAddress() noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 T* RawMemory<T, Allocator>::GetAddress() noexcept {
 	return buffer_;
 }
 
-template<typename T>
-size_t RawMemory<T>::Capacity() const noexcept {
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 size_t RawMemory<T, Allocator>::Capacity() const noexcept {
 	return capacity_;
 }
 
-template<typename T>
-void RawMemory<T>::Init(RawMemory&& other) noexcept {
-	Deallocate(buffer_);
-	buffer_ = std::exchange(other.buffer_, nullptr);
-	capacity_ = std::exchange(other.capacity_, 0);
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 const Allocator& RawMemory<T, Allocator>::GetAllocator() const noexcept {
+	return *this;
 }
 
-template<typename T>
-T* RawMemory<T>::Allocate(size_t n) {
-	return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 void RawMemory<T, Allocator>::Reset(const Allocator& alloc) noexcept {
+	Deallocate(std::exchange(buffer_, nullptr), std::exchange(capacity_, 0));
+	static_cast<Allocator&>(*this) = alloc;
 }
 
-template<typename T>
-void RawMemory<T>::Deallocate(T* buf) noexcept {
+template<typename T, typename Allocator>
+bool RawMemory<T, Allocator>::Reallocate(size_t new_capacity) noexcept {
+	static_assert(kCanReallocate, "Allocator has no reallocate()");
+	assert(buffer_ != nullptr && new_capacity != 0);
+	T* new_buffer = static_cast<Allocator&>(*this).reallocate(buffer_, capacity_, new_capacity);
+	if (new_buffer == nullptr) {
+		return false;
+	}
+	buffer_ = new_buffer;
+	capacity_ = new_capacity;
+	return true;
+}
+
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 T* RawMemory<T, Allocator>::Allocate(size_t n) {
+	return n != 0 ? AllocTraits::allocate(*this, n) : nullptr;
+}
+
+template<typename T, typename Allocator>
+ADVANCED_VECTOR_CONSTEXPR20 void RawMemory<T, Allocator>::Deallocate(T* buf, size_t n) noexcept {
 	if (buf != nullptr) {
-		operator delete(buf);
+		AllocTraits::deallocate(*this, buf, n);
 	}
 }
 
-template<typename T>
+// Selects constructors that default-initialize elements: trivial types are left unwritten
+struct DefaultInitTag {
+	explicit DefaultInitTag() = default;
+};
+
+inline constexpr DefaultInitTag DefaultInit{};
+
+template<typename It>
+using IteratorCategory = typename std::iterator_traits<It>::iterator_category;
+
+template<typename It>
+using RequireInputIterator = std::enable_if_t<std::is_base_of_v<std::input_iterator_tag, IteratorCategory<It>>>;
+
+template<typename It>
+inline constexpr bool IsForwardIteratorV = std::is_base_of_v<std::forward_iterator_tag, IteratorCategory<It>>;
+
+// Growth policies decide the capacity Vector reallocates to once it runs out of room.
+// NextCapacity receives the current capacity, the minimal capacity needed for the pending
+// insertion and sizeof(T), and must return at least required. The built-in policies are constexpr.
+
+// Doubles the capacity, starting from a single element
+struct DoublingGrowth {
+	static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept;
+};
+
+// Grows by half of the current capacity. Freed blocks of the previous generations
+// eventually add up to the next request, which lets the allocator reuse them
+struct HalfGrowth {
+	static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept;
+};
+
+// Never allocates fewer than MinCapacity elements, delegating further growth to Base
+template<size_t MinCapacity, typename Base = DoublingGrowth>
+struct MinCapacityGrowth {
+	static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept;
+};
+
+// Rounds the capacity chosen by Base up so that the buffer exactly fills a malloc size class:
+// multiples of 16 bytes for small blocks and four classes per power of two above that
+template<typename Base = DoublingGrowth>
+struct SizeClassGrowth {
+	static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept;
+
+	static constexpr size_t RoundToSizeClass(size_t bytes) noexcept;
+};
+
+constexpr size_t DoublingGrowth::NextCapacity(size_t capacity, size_t required, size_t /*element_size*/) noexcept {
+	if (capacity == 0) {
+		return std::max<size_t>(required, 1);
+	}
+	size_t doubled = capacity > SIZE_MAX / 2 ? SIZE_MAX : capacity * 2;
+	return std::max(doubled, required);
+}
+
+constexpr size_t HalfGrowth::NextCapacity(size_t capacity, size_t required, size_t /*element_size*/) noexcept {
+	size_t grown = capacity > SIZE_MAX - capacity / 2 ? SIZE_MAX : capacity + capacity / 2;
+	// Small capacities would otherwise grow by nothing or by a single element
+	return std::max({grown, capacity + 2, required});
+}
+
+template<size_t MinCapacity, typename Base>
+constexpr size_t MinCapacityGrowth<MinCapacity, Base>::NextCapacity(size_t capacity, size_t required,
+                                                                    size_t element_size) noexcept {
+	return std::max(MinCapacity, Base::NextCapacity(capacity, required, element_size));
+}
+
+template<typename Base>
+constexpr size_t SizeClassGrowth<Base>::NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept {
+	size_t base = Base::NextCapacity(capacity, required, element_size);
+	if (base > SIZE_MAX / element_size) {
+		return base;
+	}
+	return std::max(base, RoundToSizeClass(base * element_size) / element_size);
+}
+
+template<typename Base>
+constexpr size_t SizeClassGrowth<Base>::RoundToSizeClass(size_t bytes) noexcept {
+	const size_t small_step = 16;
+	const size_t small_limit = 128;
+	if (bytes <= small_limit) {
+		return (bytes + small_step - 1) / small_step * small_step;
+	}
+	size_t power = 1;
+	while (power <= (bytes - 1) / 2) {
+		power *= 2;
+	}
+	size_t step = power / 4;
+	if (bytes > SIZE_MAX - step) {
+		return bytes;
+	}
+	return (bytes + step - 1) / step * step;
+}
+
+template<typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
 class Vector {
+	using AllocTraits = std::allocator_traits<Allocator>;
+
 public:
+	using value_type = T;
+
+	using allocator_type = Allocator;
+
 	using iterator = T*;
 
 	using const_iterator = const T*;
 
-	Vector() noexcept = default;
+	// Alignment of Data() whenever the vector has a buffer, known at compile time
+	static constexpr size_t kGuaranteedAlignment = AllocatorAlignment<Allocator>::value;
+
+	Vector() noexcept(std::is_nothrow_default_constructible_v<Allocator>) = default;
+
+	ADVANCED_VECTOR_CONSTEXPR20 explicit Vector(const Allocator& alloc) noexcept;
+
+	ADVANCED_VECTOR_CONSTEXPR20 explicit Vector(size_t size, const Allocator& alloc = Allocator());
+
+	Vector(size_t size, DefaultInitTag, const Allocator& alloc = Allocator());
+
+	ADVANCED_VECTOR_CONSTEXPR20 Vector(const Vector& other);
 
-	explicit Vector(size_t size);
+	ADVANCED_VECTOR_CONSTEXPR20 Vector(const Vector& other, const Allocator& alloc);
 
-	Vector(const Vector& other);
+	ADVANCED_VECTOR_CONSTEXPR20 Vector(Vector&& other) noexcept;
 
-	Vector(Vector&& other) noexcept;
+	Vector(Vector&& other, const Allocator& alloc);
 
-	~Vector();
+	ADVANCED_VECTOR_CONSTEXPR20 ~Vector();
 
-	Vector& operator=(const Vector& rhs);
+	ADVANCED_VECTOR_CONSTEXPR20 Vector& operator=(const Vector& rhs);
 
-	Vector& operator=(Vector&& rhs) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+	                                         || AllocTraits::is_always_equal::value);
 
-	iterator begin() noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 Allocator GetAllocator() const noexcept;
 
-	iterator end() noexcept;
+	// Groups the allocation statistics of this vector under tag. No-op unless ADVANCED_VECTOR_ENABLE_STATS is defined
+	void SetStatsTag(const char* tag);
 
-	const_iterator cbegin() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 iterator begin() noexcept;
 
-	const_iterator cend() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 iterator end() noexcept;
 
-	const_iterator begin() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const_iterator cbegin() const noexcept;
 
-	const_iterator end() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const_iterator cend() const noexcept;
 
-	size_t Size() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const_iterator begin() const noexcept;
 
-	size_t Capacity() const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 const_iterator end() const noexcept;
 
-	void Swap(Vector& other) noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 size_t Size() const noexcept;
 
-	void Reserve(size_t new_capacity);
+	ADVANCED_VECTOR_CONSTEXPR20 size_t Capacity() const noexcept;
 
-	void Resize(size_t new_size);
+	ADVANCED_VECTOR_CONSTEXPR20 T* Data() noexcept;
+
+	ADVANCED_VECTOR_CONSTEXPR20 const T* Data() const noexcept;
+
+	// Checks the run-time alignment of Data(), always true up to kGuaranteedAlignment
+	bool IsAligned(size_t alignment) const noexcept;
+
+	// Allocators are swapped only when they propagate on swap, otherwise they must compare equal
+	ADVANCED_VECTOR_CONSTEXPR20 void Swap(Vector& other) noexcept;
+
+	ADVANCED_VECTOR_CONSTEXPR20 void Reserve(size_t new_capacity);
+
+	// Drops the spare capacity. Same exception guarantee as Reserve
+	ADVANCED_VECTOR_CONSTEXPR20 void ShrinkToFit();
+
+	// Destroys the elements and keeps the capacity
+	ADVANCED_VECTOR_CONSTEXPR20 void Clear() noexcept;
+
+	// Destroys the elements and returns the buffer to the allocator
+	ADVANCED_VECTOR_CONSTEXPR20 void ReleaseMemory() noexcept;
+
+	ADVANCED_VECTOR_CONSTEXPR20 void Resize(size_t new_size);
+
+	// Like Resize, but new elements are default-initialized instead of value-initialized
+	void ResizeDefaultInit(size_t new_size);
+
+	// Grows or shrinks without touching the memory of new elements, which hold indeterminate values.
+	// Only for trivial types, meant for buffers that are filled right after (read(), decoders)
+	void ResizeUninitialized(size_t new_size);
 
 	template<typename... Args>
-	T& EmplaceBack(Args &&... args);
+	ADVANCED_VECTOR_CONSTEXPR20 T& EmplaceBack(Args &&... args);
 
 	template<typename... Args>
 	iterator Emplace(const_iterator pos, Args &&... args);
 
-	iterator Erase(const_iterator pos);
+	ADVANCED_VECTOR_CONSTEXPR20 iterator Erase(const_iterator pos);
+
+	// Removes [first, last) with a single shift of the tail
+	ADVANCED_VECTOR_CONSTEXPR20 iterator Erase(const_iterator first, const_iterator last);
 
 	iterator Insert(const_iterator pos, const T& item);
 
 	iterator Insert(const_iterator pos, T&& item);
 
-	T& PushBack(const T& value);
+	iterator Insert(const_iterator pos, size_t count, const T& item);
 
-	T& PushBack(T&& value);
+	// Inserts [first, last) before pos reallocating at most once and shifting the tail once.
+	// The range must not point into this vector
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	iterator Insert(const_iterator pos, InputIt first, InputIt last);
+
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	void Append(InputIt first, InputIt last);
 
-	void PopBack() noexcept;
+	// Replaces the contents with [first, last). Allocates exactly the range size when the capacity is too small
+	template<typename InputIt, typename = RequireInputIterator<InputIt>>
+	void Assign(InputIt first, InputIt last);
 
-	const T& operator[](size_t index) const noexcept;
-	T& operator[](size_t index) noexcept;
+	void Assign(size_t count, const T& value);
+
+	ADVANCED_VECTOR_CONSTEXPR20 T& PushBack(const T& value);
+
+	ADVANCED_VECTOR_CONSTEXPR20 T& PushBack(T&& value);
+
+	ADVANCED_VECTOR_CONSTEXPR20 void PopBack() noexcept;
+
+	// EmplaceBack without the capacity check, for loops that reserved the room up front.
+	// Size() must be less than Capacity()
+	template<typename... Args>
+	ADVANCED_VECTOR_CONSTEXPR20 T& EmplaceBackUnchecked(Args &&... args);
+
+	// Appends a known number of elements without a capacity check per element, see AppendScope
+	class AppendScope;
+
+	// Reserves room for count more elements and returns a scope that constructs into it
+	AppendScope BeginAppend(size_t count);
+
+	ADVANCED_VECTOR_CONSTEXPR20 const T& operator[](size_t index) const noexcept;
+	ADVANCED_VECTOR_CONSTEXPR20 T& operator[](size_t index) noexcept;
 
 private:
-	RawMemory<T> data_;
+	// Forward iterator that yields the same value forever, lets the count + value overloads share the range code
+	class RepeatIterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		explicit RepeatIterator(const T& value) noexcept : value_(&value) {}
+
+		reference operator*() const noexcept {return *value_;}
+
+		RepeatIterator& operator++() noexcept {return *this;}
+
+		RepeatIterator operator++(int) noexcept {return *this;}
+
+		bool operator==(const RepeatIterator& other) const noexcept {return value_ == other.value_;}
+
+		bool operator!=(const RepeatIterator& other) const noexcept {return value_ != other.value_;}
+
+	private:
+		const T* value_;
+	};
+
+	RawMemory<T, Allocator> data_;
 
 	size_t size_ = 0;
 
-	static void SafeMove(T* from, size_t size, T* to);
+	ADVANCED_VECTOR_STATS(
+		VectorStatsCounters* stats_ = nullptr;
+
+		VectorStatsCounters& Stats() const noexcept;
+
+		ADVANCED_VECTOR_CONSTEXPR20 void RecordAllocation(size_t capacity) const noexcept;
+
+		ADVANCED_VECTOR_CONSTEXPR20 void RecordReallocation(size_t capacity, size_t moved) const noexcept;
+
+		void RecordInPlaceReallocation(size_t capacity) const noexcept;
+	)
+
+	static ADVANCED_VECTOR_CONSTEXPR20 void SafeMove(T* from, size_t size, T* to);
+
+	static constexpr bool kCanReallocateInPlace = IsTriviallyRelocatableV<T> && RawMemory<T, Allocator>::kCanReallocate;
+
+	// Resizes the existing buffer through the allocator without touching the elements.
+	// Returns false when unsupported or when the allocator could not do it
+	ADVANCED_VECTOR_CONSTEXPR20 bool TryReallocateInPlace(size_t new_capacity) noexcept;
+
+	// Moves the elements into new_data leaving a hole of gap elements at index.
+	// If copying throws, new_data holds no elements and *this is unchanged
+	ADVANCED_VECTOR_CONSTEXPR20 void RelocateAround(RawMemory<T, Allocator>& new_data, size_t index, size_t gap);
+
+	template<typename ForwardIt>
+	iterator InsertRange(size_t index, ForwardIt first, size_t count);
+
+	template<typename ForwardIt>
+	void AssignRange(ForwardIt first, size_t count);
+
+	void MoveAssignElements(Vector& rhs);
+
+	// Capacity to reallocate to when at least required elements must fit
+	ADVANCED_VECTOR_CONSTEXPR20 size_t NextCapacity(size_t required) const noexcept;
+
+	// The single reallocating path of Reserve, ShrinkToFit, Resize and the emplacing calls. Moves the
+	// elements into a buffer of new_capacity leaving a hole of count elements at index, which
+	// construct(hole) fills first, so arguments referring to elements are still alive while it runs.
+	// If construct throws, *this is unchanged
+	template<typename Construct>
+	ADVANCED_VECTOR_COLD ADVANCED_VECTOR_CONSTEXPR20 void Reallocate(size_t index, size_t count, size_t new_capacity, Construct&& construct);
 
 	template<typename... Args>
-	iterator EmplaceWithReallocate(const_iterator pos, Args &&... args);
+	ADVANCED_VECTOR_COLD ADVANCED_VECTOR_CONSTEXPR20 iterator EmplaceWithReallocate(size_t index, Args &&... args);
 
 	template<typename... Args>
 	iterator EmplaceWithoutReallocate(const_iterator pos, Args &&... args);
 };
 
-template<typename T>
-typename Vector<T>::iterator Vector<T>::begin() noexcept {
+// Constructs up to the reserved count of elements past the end of a vector, keeping the write
+// position in a local pointer instead of updating and checking the vector's size per element.
+// The vector's size is committed when the scope ends. If the scope is left by an exception
+// thrown after it was created, the elements it constructed are destroyed and the vector keeps
+// its old contents. The vector must not be used otherwise while the scope is alive
+template<typename T, typename Allocator, typename GrowthPolicy>
+class Vector<T, Allocator, GrowthPolicy>::AppendScope {
+public:
+	AppendScope(const AppendScope&) = delete;
+
+	AppendScope& operator=(const AppendScope&) = delete;
+
+	~AppendScope();
+
+	// At most the reserved count of elements may be added
+	template<typename... Args>
+	T& EmplaceBack(Args &&... args);
+
+	T& PushBack(const T& value);
+
+	T& PushBack(T&& value);
+
+	// Number of elements that may still be added
+	size_t Remaining() const noexcept;
+
+private:
+	friend class Vector;
+
+	AppendScope(Vector& vector, size_t count);
+
+	Vector& vector_;
+
+	T* end_;
+
+	T* limit_;
+
+	int uncaught_ = std::uncaught_exceptions();
+};
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::iterator Vector<T, Allocator, GrowthPolicy>::begin() noexcept {
 	return data_.GetAddress();
 }
 
-template<typename T>
-typename Vector<T>::iterator Vector<T>::end() noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::iterator Vector<T, Allocator, GrowthPolicy>::end() noexcept {
 	return data_ + size_;
 }
 
-template<typename T>
-typename Vector<T>::const_iterator Vector<T>::begin() const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::const_iterator Vector<T, Allocator, GrowthPolicy>::begin() const noexcept {
 	return data_.GetAddress();
 }
 
-template<typename T>
-typename Vector<T>::const_iterator Vector<T>::end() const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::const_iterator Vector<T, Allocator, GrowthPolicy>::end() const noexcept {
 	return data_ + size_;
 }
 
-template<typename T>
-typename Vector<T>::const_iterator Vector<T>::cbegin() const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::const_iterator Vector<T, Allocator, GrowthPolicy>::cbegin() const noexcept {
 	return data_.GetAddress();
 }
 
-template<typename T>
-typename Vector<T>::const_iterator Vector<T>::cend() const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::const_iterator Vector<T, Allocator, GrowthPolicy>::cend() const noexcept {
 	return data_ + size_;
 }
 
-template<typename T>
-Vector<T>::Vector(size_t size)
-	: data_(size), size_(size)
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>::Vector(const Allocator& alloc) noexcept
+	: data_(alloc)
 {
-	std::uninitialized_value_construct_n(data_.GetAddress(), size);
 }
 
-template<typename T>
-Vector<T>::Vector(const Vector& other)
-	: data_(other.size_), size_(other.size_)
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>::Vector(size_t size, const Allocator& alloc)
+	: data_(size, alloc), size_(size)
 {
-	std::uninitialized_copy_n(other.data_.GetAddress(), size_, data_.GetAddress());
+	BulkExecution::ValueConstruct(data_.GetAddress(), size);
+	ADVANCED_VECTOR_STATS(RecordAllocation(size);)
 }
 
-template<typename T>
-Vector<T>::Vector(Vector<T>&& other) noexcept {
-	data_ = std::move(other.data_);
-	size_ = std::exchange(other.size_, 0);
+template<typename T, typename Allocator, typename GrowthPolicy>
+Vector<T, Allocator, GrowthPolicy>::Vector(size_t size, DefaultInitTag, const Allocator& alloc)
+	: data_(size, alloc), size_(size)
+{
+	std::uninitialized_default_construct_n(data_.GetAddress(), size);
+	ADVANCED_VECTOR_STATS(RecordAllocation(size);)
 }
 
-template<typename T>
-Vector<T>& Vector<T>::operator=(const Vector<T>& rhs) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>::Vector(const Vector& other)
+	: Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator()))
+{
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>::Vector(const Vector& other, const Allocator& alloc)
+	: data_(other.size_, alloc), size_(other.size_)
+{
+	BulkExecution::Copy(other.data_.GetAddress(), size_, data_.GetAddress());
+	ADVANCED_VECTOR_STATS(RecordAllocation(size_);)
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>::Vector(Vector<T, Allocator, GrowthPolicy>&& other) noexcept
+	: data_(std::move(other.data_)), size_(std::exchange(other.size_, 0))
+{
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+Vector<T, Allocator, GrowthPolicy>::Vector(Vector<T, Allocator, GrowthPolicy>&& other, const Allocator& alloc)
+	: data_(alloc)
+{
+	if (alloc == other.GetAllocator()) {
+		data_ = std::move(other.data_);
+		size_ = std::exchange(other.size_, 0);
+	}
+	else {
+		MoveAssignElements(other);
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>& Vector<T, Allocator, GrowthPolicy>::operator=(const Vector<T, Allocator, GrowthPolicy>& rhs) {
 	if (this != &rhs) {
+		if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+			if (GetAllocator() != rhs.GetAllocator()) {
+				// Our buffer has to go back to the allocator that produced it
+				std::destroy_n(data_.GetAddress(), size_);
+				size_ = 0;
+				data_.Reset(rhs.GetAllocator());
+			}
+		}
 		if (rhs.size_ > data_.Capacity()) {
-			Vector rhs_copy(rhs);
-			Swap(rhs_copy);
+			RawMemory<T, Allocator> new_data{rhs.size_, data_.GetAllocator()};
+			BulkExecution::Copy(rhs.data_.GetAddress(), rhs.size_, new_data.GetAddress());
+			BulkExecution::Destroy(data_.GetAddress(), size_);
+			data_.Swap(new_data);
+			size_ = rhs.size_;
+			ADVANCED_VECTOR_STATS(RecordAllocation(data_.Capacity());)
 		}
 		else {
 			size_t copy_elem = rhs.size_ < size_ ? rhs.size_ : size_;
@@ -274,7 +967,7 @@ Vector<T>& Vector<T>::operator=(const Vector<T>& rhs) {
 				std::destroy_n(end, size_ - rhs.size_);
 			}
 			else {
-				std::uninitialized_copy_n(rhs.data_.GetAddress() + size_, rhs.size_ - size_, end);
+				vector_detail::UninitializedCopyN(rhs.data_.GetAddress() + size_, rhs.size_ - size_, end);
 			}
 			size_ = rhs.size_;
 		}
@@ -282,188 +975,563 @@ Vector<T>& Vector<T>::operator=(const Vector<T>& rhs) {
 	return *this;
 }
 
-template<typename T>
-Vector<T>& Vector<T>::operator=(Vector<T>&& rhs) noexcept {
-	Swap(rhs);
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>& Vector<T, Allocator, GrowthPolicy>::operator=(Vector<T, Allocator, GrowthPolicy>&& rhs)
+	noexcept(AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
+	if (this != &rhs) {
+		if (AllocTraits::propagate_on_container_move_assignment::value || GetAllocator() == rhs.GetAllocator()) {
+			std::destroy_n(data_.GetAddress(), size_);
+			data_ = std::move(rhs.data_);
+			size_ = std::exchange(rhs.size_, 0);
+		}
+		else {
+			// The buffer belongs to an unequal allocator that stays with rhs, so move element by element
+			MoveAssignElements(rhs);
+		}
+	}
 	return *this;
 }
 
-template<typename T>
-Vector<T>::~Vector() {
-	std::destroy_n(data_.GetAddress(), size_);
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Allocator Vector<T, Allocator, GrowthPolicy>::GetAllocator() const noexcept {
+	return data_.GetAllocator();
 }
 
-template<typename T>
-void Vector<T>::Swap(Vector<T>& other) noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+void Vector<T, Allocator, GrowthPolicy>::SetStatsTag([[maybe_unused]] const char* tag) {
+	ADVANCED_VECTOR_STATS(stats_ = &VectorStats::ForTag(tag);)
+}
+
+#ifdef ADVANCED_VECTOR_ENABLE_STATS
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+VectorStatsCounters& Vector<T, Allocator, GrowthPolicy>::Stats() const noexcept {
+	return stats_ != nullptr ? *stats_ : VectorStats::Untagged();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::RecordAllocation(size_t capacity) const noexcept {
+	if (capacity != 0 && !vector_detail::IsConstantEvaluated()) {
+		Stats().RecordAllocation(capacity * sizeof(T));
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::RecordReallocation(size_t capacity, size_t moved) const noexcept {
+	constexpr bool copies = !IsTriviallyRelocatableV<T> && !std::is_nothrow_move_constructible_v<T>
+	                        && std::is_copy_constructible_v<T>;
+	if (vector_detail::IsConstantEvaluated()) {
+		return;
+	}
+	if (moved == 0) {
+		// Nothing was carried over, so this is the first buffer as far as the element traffic goes
+		RecordAllocation(capacity);
+		return;
+	}
+	Stats().RecordReallocation(capacity * sizeof(T), moved * sizeof(T), copies ? moved : 0);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void Vector<T, Allocator, GrowthPolicy>::RecordInPlaceReallocation(size_t capacity) const noexcept {
+	Stats().RecordInPlaceReallocation(capacity * sizeof(T));
+}
+
+#endif
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 Vector<T, Allocator, GrowthPolicy>::~Vector() {
+	BulkExecution::Destroy(data_.GetAddress(), size_);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::Swap(Vector<T, Allocator, GrowthPolicy>& other) noexcept {
 	data_.Swap(other.data_);
 	std::swap(size_, other.size_);
 }
 
-template<typename T>
-size_t Vector<T>::Size() const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 size_t Vector<T, Allocator, GrowthPolicy>::Size() const noexcept {
 	return size_;
 }
 
-template<typename T>
-size_t Vector<T>::Capacity() const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 size_t Vector<T, Allocator, GrowthPolicy>::Capacity() const noexcept {
 	return data_.Capacity();
 }
 
-template<typename T>
-void Vector<T>::Reserve(size_t new_capacity) {
-	if (new_capacity <= data_.Capacity()) {
-		return;
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 T* Vector<T, Allocator, GrowthPolicy>::Data() noexcept {
+	return data_.GetAddress();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 const T* Vector<T, Allocator, GrowthPolicy>::Data() const noexcept {
+	return data_.GetAddress();
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+bool Vector<T, Allocator, GrowthPolicy>::IsAligned(size_t alignment) const noexcept {
+	return reinterpret_cast<uintptr_t>(data_.GetAddress()) % alignment == 0;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::Reserve(size_t new_capacity) {
+	if (new_capacity > data_.Capacity()) {
+		Reallocate(size_, 0, new_capacity, [](T*) noexcept {});
 	}
-	RawMemory<T> new_data{new_capacity};
-	SafeMove(data_.GetAddress(), size_, new_data.GetAddress());
-	data_.Swap(new_data);
 }
 
-template<typename T>
-void Vector<T>::Resize(size_t new_size) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::ShrinkToFit() {
+	if (size_ != data_.Capacity()) {
+		Reallocate(size_, 0, size_, [](T*) noexcept {});
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::Clear() noexcept {
+	std::destroy_n(data_.GetAddress(), size_);
+	size_ = 0;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::ReleaseMemory() noexcept {
+	Clear();
+	RawMemory<T, Allocator> empty{data_.GetAllocator()};
+	data_.Swap(empty);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::Resize(size_t new_size) {
 	if (new_size < size_) {
 		std::destroy_n(data_.GetAddress() + new_size, size_ - new_size);
 	}
 	else if (new_size > size_) {
-		Reserve(new_size);
-		std::uninitialized_value_construct_n(data_.GetAddress() + size_, new_size - size_);
+		size_t count = new_size - size_;
+		if (new_size > data_.Capacity()) {
+			Reallocate(size_, count, new_size, [count](T* hole) {vector_detail::UninitializedValueConstructN(hole, count);});
+			return;
+		}
+		vector_detail::UninitializedValueConstructN(data_ + size_, count);
 	}
 	size_ = new_size;
 }
 
-template<typename T>
-T& Vector<T>::PushBack(const T& value) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+void Vector<T, Allocator, GrowthPolicy>::ResizeDefaultInit(size_t new_size) {
+	if (new_size < size_) {
+		std::destroy_n(data_.GetAddress() + new_size, size_ - new_size);
+	}
+	else if (new_size > size_) {
+		size_t count = new_size - size_;
+		if (new_size > data_.Capacity()) {
+			Reallocate(size_, count, new_size, [count](T* hole) {std::uninitialized_default_construct_n(hole, count);});
+			return;
+		}
+		std::uninitialized_default_construct_n(data_ + size_, count);
+	}
+	size_ = new_size;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void Vector<T, Allocator, GrowthPolicy>::ResizeUninitialized(size_t new_size) {
+	static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+	              "ResizeUninitialized requires a trivial element type");
+	Reserve(new_size);
+	size_ = new_size;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 T& Vector<T, Allocator, GrowthPolicy>::PushBack(const T& value) {
 	return EmplaceBack(value);
 }
 
-template<typename T>
-T& Vector<T>::PushBack(T&& value) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 T& Vector<T, Allocator, GrowthPolicy>::PushBack(T&& value) {
 	return EmplaceBack(std::move(value));
 }
 
-template<typename T>
-void Vector<T>::PopBack() noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::PopBack() noexcept {
 	assert(size_ > 0);
 	std::destroy_at(data_ + (size_ - 1));
 	--size_;
 }
 
-template<typename T>
+template<typename T, typename Allocator, typename GrowthPolicy>
 template<typename... Args>
-T& Vector<T>::EmplaceBack(Args &&... args) {
+ADVANCED_VECTOR_CONSTEXPR20 T& Vector<T, Allocator, GrowthPolicy>::EmplaceBackUnchecked(Args &&... args) {
+	assert(size_ < data_.Capacity());
+	T* slot = vector_detail::ConstructAt(data_ + size_, std::forward<Args>(args)...);
+	++size_;
+	return *slot;
+}
 
-	if (size_ == Capacity()) {
-		RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-		auto sp_var = new (new_data + size_) T(std::forward<Args>(args)...);
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename Vector<T, Allocator, GrowthPolicy>::AppendScope Vector<T, Allocator, GrowthPolicy>::BeginAppend(size_t count) {
+	return AppendScope(*this, count);
+}
 
-		try {
-			if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-				std::uninitialized_move_n(data_.GetAddress(), size_, new_data.GetAddress());
-			}
-			else {
-				std::uninitialized_copy_n(data_.GetAddress(), size_, new_data.GetAddress());
-			}
-		}
-		catch (...) {
-            ::operator delete(sp_var);
-            throw;
-		}
-		std::destroy_n(data_.GetAddress(), size_);
-		data_.Swap(new_data);
+template<typename T, typename Allocator, typename GrowthPolicy>
+Vector<T, Allocator, GrowthPolicy>::AppendScope::AppendScope(Vector& vector, size_t count)
+	: vector_(vector)
+{
+	vector_.Reserve(vector_.size_ + count);
+	end_ = vector_.data_ + vector_.size_;
+	limit_ = end_ + count;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+Vector<T, Allocator, GrowthPolicy>::AppendScope::~AppendScope() {
+	T* begin = vector_.data_ + vector_.size_;
+	if (std::uncaught_exceptions() > uncaught_) {
+		std::destroy(begin, end_);
 	}
 	else {
-		new (data_ + size_) T(std::forward<Args>(args)...);
+		vector_.size_ += static_cast<size_t>(end_ - begin);
 	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename... Args>
+T& Vector<T, Allocator, GrowthPolicy>::AppendScope::EmplaceBack(Args &&... args) {
+	assert(end_ < limit_);
+	T* slot = new (end_) T(std::forward<Args>(args)...);
+	++end_;
+	return *slot;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& Vector<T, Allocator, GrowthPolicy>::AppendScope::PushBack(const T& value) {
+	return EmplaceBack(value);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+T& Vector<T, Allocator, GrowthPolicy>::AppendScope::PushBack(T&& value) {
+	return EmplaceBack(std::move(value));
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+size_t Vector<T, Allocator, GrowthPolicy>::AppendScope::Remaining() const noexcept {
+	return static_cast<size_t>(limit_ - end_);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename... Args>
+ADVANCED_VECTOR_CONSTEXPR20 T& Vector<T, Allocator, GrowthPolicy>::EmplaceBack(Args &&... args) {
+	if (ADVANCED_VECTOR_UNLIKELY(size_ == data_.Capacity())) {
+		return *EmplaceWithReallocate(size_, std::forward<Args>(args)...);
+	}
+	vector_detail::ConstructAt(data_ + size_, std::forward<Args>(args)...);
 	++size_;
 	return data_[size_ - 1];
 }
 
-template<typename T>
+template<typename T, typename Allocator, typename GrowthPolicy>
 template<typename... Args>
-typename Vector<T>::iterator Vector<T>::Emplace(const_iterator pos, Args &&... args) {
+typename Vector<T, Allocator, GrowthPolicy>::iterator Vector<T, Allocator, GrowthPolicy>::Emplace(const_iterator pos, Args &&... args) {
 	if (pos == end()) {
 		return &EmplaceBack(std::forward<Args>(args)...);
 	}
 	if (size_ == Capacity()) {
-		return EmplaceWithReallocate(pos, std::forward<Args>(args)...);
+		return EmplaceWithReallocate(static_cast<size_t>(pos - cbegin()), std::forward<Args>(args)...);
 	}
 	else {
 		return EmplaceWithoutReallocate(pos, std::forward<Args>(args)...);
 	}
 }
 
-template<typename T>
-typename Vector<T>::iterator Vector<T>::Insert(const_iterator pos, const T& value) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename Vector<T, Allocator, GrowthPolicy>::iterator Vector<T, Allocator, GrowthPolicy>::Insert(const_iterator pos, const T& value) {
 	return Emplace(pos, value);
 }
 
-template<typename T>
-typename Vector<T>::iterator Vector<T>::Insert(const_iterator pos, T&& value) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename Vector<T, Allocator, GrowthPolicy>::iterator Vector<T, Allocator, GrowthPolicy>::Insert(const_iterator pos, T&& value) {
 	return Emplace(pos, std::move(value));
 }
 
-template<typename T>
-typename Vector<T>::iterator Vector<T>::Erase(const_iterator pos) {
+template<typename T, typename Allocator, typename GrowthPolicy>
+typename Vector<T, Allocator, GrowthPolicy>::iterator
+Vector<T, Allocator, GrowthPolicy>::Insert(const_iterator pos, size_t count, const T& value) {
+	auto index = static_cast<size_t>(pos - begin());
+	if (count == 0) {
+		return begin() + index;
+	}
+	if (size_ + count > data_.Capacity() && !kCanReallocateInPlace) {
+		// value is copied into the new buffer before the old one is touched, so it may alias an element
+		return InsertRange(index, RepeatIterator(value), count);
+	}
+	T temp(value);
+	return InsertRange(index, RepeatIterator(temp), count);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename InputIt, typename>
+typename Vector<T, Allocator, GrowthPolicy>::iterator
+Vector<T, Allocator, GrowthPolicy>::Insert(const_iterator pos, InputIt first, InputIt last) {
+	auto index = static_cast<size_t>(pos - begin());
+	if constexpr (IsForwardIteratorV<InputIt>) {
+		return InsertRange(index, first, static_cast<size_t>(std::distance(first, last)));
+	}
+	else {
+		// A single-pass range can not be measured up front: append it and rotate it into place
+		size_t old_size = size_;
+		for (; first != last; ++first) {
+			EmplaceBack(*first);
+		}
+		std::rotate(begin() + index, begin() + old_size, end());
+		return begin() + index;
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename InputIt, typename>
+void Vector<T, Allocator, GrowthPolicy>::Append(InputIt first, InputIt last) {
+	Insert(cend(), first, last);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename InputIt, typename>
+void Vector<T, Allocator, GrowthPolicy>::Assign(InputIt first, InputIt last) {
+	if constexpr (IsForwardIteratorV<InputIt>) {
+		AssignRange(first, static_cast<size_t>(std::distance(first, last)));
+	}
+	else {
+		Clear();
+		for (; first != last; ++first) {
+			EmplaceBack(*first);
+		}
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void Vector<T, Allocator, GrowthPolicy>::Assign(size_t count, const T& value) {
+	AssignRange(RepeatIterator(value), count);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::iterator Vector<T, Allocator, GrowthPolicy>::Erase(const_iterator pos) {
 	auto index = static_cast<size_t>(pos - begin());
 	std::move(begin() + index + 1, end(), begin() + index);
 	PopBack();
 	return begin() + index;
 }
 
-template<typename T>
-const T& Vector<T>::operator[](size_t index) const noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::iterator
+Vector<T, Allocator, GrowthPolicy>::Erase(const_iterator first, const_iterator last) {
+	auto index = static_cast<size_t>(first - begin());
+	auto count = static_cast<size_t>(last - first);
+	if (count != 0) {
+		auto new_end = std::move(begin() + index + count, end(), begin() + index);
+		std::destroy_n(new_end, count);
+		size_ -= count;
+	}
+	return begin() + index;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 const T& Vector<T, Allocator, GrowthPolicy>::operator[](size_t index) const noexcept {
 	return const_cast<Vector&>(*this)[index];
 }
 
-template<typename T>
-T& Vector<T>::operator[](size_t index) noexcept {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 T& Vector<T, Allocator, GrowthPolicy>::operator[](size_t index) noexcept {
 	assert(index < size_);
 	return data_[index];
 }
 
-template<typename T>
-void Vector<T>::SafeMove(T* from, size_t size, T* to) {
-	if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-		std::uninitialized_move_n(from, size, to);
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::SafeMove(T* from, size_t size, T* to) {
+	BulkExecution::Relocate(from, size, to);
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void Vector<T, Allocator, GrowthPolicy>::MoveAssignElements(Vector& rhs) {
+	if (rhs.size_ > data_.Capacity()) {
+		RawMemory<T, Allocator> new_data{rhs.size_, data_.GetAllocator()};
+		std::uninitialized_move_n(rhs.data_.GetAddress(), rhs.size_, new_data.GetAddress());
+		std::destroy_n(data_.GetAddress(), size_);
+		data_.Swap(new_data);
+		ADVANCED_VECTOR_STATS(RecordAllocation(data_.Capacity());)
 	}
 	else {
-		std::uninitialized_copy_n(from, size, to);
+		size_t move_elem = rhs.size_ < size_ ? rhs.size_ : size_;
+		auto end = std::move(rhs.data_.GetAddress(), rhs.data_.GetAddress() + move_elem, data_.GetAddress());
+		if (rhs.size_ < size_) {
+			std::destroy_n(end, size_ - rhs.size_);
+		}
+		else {
+			std::uninitialized_move_n(rhs.data_.GetAddress() + size_, rhs.size_ - size_, end);
+		}
 	}
-	std::destroy_n(from, size);
+	size_ = rhs.size_;
+	std::destroy_n(rhs.data_.GetAddress(), rhs.size_);
+	rhs.size_ = 0;
 }
 
-template<typename T>
-template<typename... Args>
-typename Vector<T>::iterator
-Vector<T>::EmplaceWithReallocate(const_iterator pos, Args &&... args) {
-	auto index = static_cast<size_t>(pos - begin());
-	RawMemory<T> new_data{size_ == 0 ? 1 : size_ * 2};
-	new(new_data + index) T(std::forward<Args>(args)...);
-	try {
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::RelocateAround(RawMemory<T, Allocator>& new_data, size_t index, size_t gap) {
+	if (index == size_) {
+		// Nothing follows the hole, a plain relocation keeps the strong guarantee and may run in parallel
+		SafeMove(data_.GetAddress(), size_, new_data.GetAddress());
+		return;
+	}
+	if constexpr (IsTriviallyRelocatableV<T> || std::is_nothrow_move_constructible_v<T>
+	              || !std::is_copy_constructible_v<T>) {
 		SafeMove(data_.GetAddress(), index, new_data.GetAddress());
+		try {
+			SafeMove(data_ + index, size_ - index, new_data + (index + gap));
+		}
+		catch (...) {
+			// Only a throwing move of a move-only type gets here; the prefix is gone, so leave an empty vector
+			std::destroy_n(new_data.GetAddress(), index);
+			std::destroy_n(data_ + index, size_ - index);
+			size_ = 0;
+			throw;
+		}
 	}
-	catch (...) {
-		new_data[index].~T();
-		throw;
+	else {
+		// Both halves are copied before any source element is destroyed
+		vector_detail::UninitializedCopyN(data_.GetAddress(), index, new_data.GetAddress());
+		try {
+			vector_detail::UninitializedCopyN(data_ + index, size_ - index, new_data + (index + gap));
+		}
+		catch (...) {
+			std::destroy_n(new_data.GetAddress(), index);
+			throw;
+		}
+		std::destroy_n(data_.GetAddress(), size_);
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename ForwardIt>
+typename Vector<T, Allocator, GrowthPolicy>::iterator
+Vector<T, Allocator, GrowthPolicy>::InsertRange(size_t index, ForwardIt first, size_t count) {
+	if (count == 0) {
+		return begin() + index;
+	}
+	if (size_ + count > data_.Capacity()) {
+		Reallocate(index, count, NextCapacity(size_ + count), [first, count](T* hole) {std::uninitialized_copy_n(first, count, hole);});
+		return begin() + index;
+	}
+
+	size_t tail = size_ - index;
+	T* pos = data_ + index;
+	T* old_end = data_ + size_;
+	if (tail > count) {
+		// The last count elements move to raw memory, the rest of the tail shifts within the constructed part
+		std::uninitialized_move(old_end - count, old_end, old_end);
+		size_ += count;
+		std::move_backward(pos, old_end - count, old_end);
+		std::copy_n(first, count, pos);
+	}
+	else {
+		// The part of the range beyond the old end is constructed in place, the tail moves past it
+		std::uninitialized_copy_n(std::next(first, tail), count - tail, old_end);
+		size_ += count - tail;
+		std::uninitialized_move(pos, old_end, pos + count);
+		size_ += tail;
+		std::copy_n(first, tail, pos);
+	}
+	return begin() + index;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename ForwardIt>
+void Vector<T, Allocator, GrowthPolicy>::AssignRange(ForwardIt first, size_t count) {
+	if (count > data_.Capacity()) {
+		RawMemory<T, Allocator> new_data{count, data_.GetAllocator()};
+		std::uninitialized_copy_n(first, count, new_data.GetAddress());
+		std::destroy_n(data_.GetAddress(), size_);
+		data_.Swap(new_data);
+		ADVANCED_VECTOR_STATS(RecordAllocation(data_.Capacity());)
 	}
+	else if (count <= size_) {
+		std::copy_n(first, count, data_.GetAddress());
+		std::destroy_n(data_ + count, size_ - count);
+	}
+	else {
+		std::copy_n(first, size_, data_.GetAddress());
+		std::uninitialized_copy_n(std::next(first, size_), count - size_, data_ + size_);
+	}
+	size_ = count;
+}
 
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 bool Vector<T, Allocator, GrowthPolicy>::TryReallocateInPlace([[maybe_unused]] size_t new_capacity) noexcept {
+	if constexpr (kCanReallocateInPlace) {
+		if (data_.Capacity() != 0 && new_capacity != 0 && data_.Reallocate(new_capacity)) {
+			ADVANCED_VECTOR_STATS(RecordInPlaceReallocation(new_capacity);)
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+ADVANCED_VECTOR_CONSTEXPR20 size_t Vector<T, Allocator, GrowthPolicy>::NextCapacity(size_t required) const noexcept {
+	size_t new_capacity = GrowthPolicy::NextCapacity(data_.Capacity(), required, sizeof(T));
+	assert(new_capacity >= required);
+	return new_capacity;
+}
+
+// Under C++20 the cold paths are constexpr and so implicitly inline. GCC warns about combining
+// that with noinline, but still keeps them out of line
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wattributes"
+#endif
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename Construct>
+ADVANCED_VECTOR_CONSTEXPR20 void Vector<T, Allocator, GrowthPolicy>::Reallocate(size_t index, size_t count, size_t new_capacity, Construct&& construct) {
+	if (index == size_ && TryReallocateInPlace(new_capacity)) {
+		construct(data_ + size_);
+		size_ += count;
+		return;
+	}
+	RawMemory<T, Allocator> new_data{new_capacity, data_.GetAllocator()};
+	construct(new_data + index);
 	try {
-		SafeMove(data_ + index, size_ - index, new_data + (index + 1));
+		RelocateAround(new_data, index, count);
 	}
 	catch (...) {
-		std::destroy_n(new_data.GetAddress(), index + 1);
+		std::destroy_n(new_data + index, count);
 		throw;
 	}
 	data_.Swap(new_data);
+	ADVANCED_VECTOR_STATS(RecordReallocation(data_.Capacity(), size_);)
+	size_ += count;
+}
 
-	++size_;
+template<typename T, typename Allocator, typename GrowthPolicy>
+template<typename... Args>
+ADVANCED_VECTOR_CONSTEXPR20 typename Vector<T, Allocator, GrowthPolicy>::iterator
+Vector<T, Allocator, GrowthPolicy>::EmplaceWithReallocate(size_t index, Args &&... args) {
+	size_t new_capacity = NextCapacity(size_ + 1);
+	if constexpr (kCanReallocateInPlace) {
+		// The buffer may be resized in place before the hole is filled, so args that refer to an element are read first
+		if (index == size_ && size_ != 0) {
+			T value(std::forward<Args>(args)...);
+			Reallocate(index, 1, new_capacity, [&value](T* hole) noexcept {vector_detail::ConstructAt(hole, std::move(value));});
+			return begin() + index;
+		}
+	}
+	Reallocate(index, 1, new_capacity, [&](T* hole) {vector_detail::ConstructAt(hole, std::forward<Args>(args)...);});
 	return begin() + index;
 }
 
-template<typename T>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+template<typename T, typename Allocator, typename GrowthPolicy>
 template<typename... Args>
-typename Vector<T>::iterator
-Vector<T>::EmplaceWithoutReallocate(const_iterator pos, Args &&... args) {
+typename Vector<T, Allocator, GrowthPolicy>::iterator
+Vector<T, Allocator, GrowthPolicy>::EmplaceWithoutReallocate(const_iterator pos, Args &&... args) {
 	auto index = static_cast<size_t>(pos - begin());
 	T temp(std::forward<Args>(args)...);
 	new(end()) T(std::move(data_[size_ - 1]));
@@ -474,8 +1542,24 @@ Vector<T>::EmplaceWithoutReallocate(const_iterator pos, Args &&... args) {
 	return begin() + index;
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& out, const Vector<T>& vector) {
+// Removes every element satisfying pred in one compaction pass and returns how many were removed
+template<typename T, typename Allocator, typename GrowthPolicy, typename Predicate>
+size_t EraseIf(Vector<T, Allocator, GrowthPolicy>& vector, Predicate pred) {
+	auto new_end = std::remove_if(vector.begin(), vector.end(), pred);
+	auto removed = static_cast<size_t>(vector.end() - new_end);
+	vector.Erase(new_end, vector.end());
+	return removed;
+}
+
+namespace pmr {
+
+template<typename T, typename GrowthPolicy = DoublingGrowth>
+using Vector = ::Vector<T, std::pmr::polymorphic_allocator<T>, GrowthPolicy>;
+
+}//end namespace pmr
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+std::ostream& operator<<(std::ostream& out, const Vector<T, Allocator, GrowthPolicy>& vector) {
 	out << "[ ";
 	for (const auto& elem : vector) {
 		out << elem << " ";
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "vector.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Binary I/O for vectors of trivially copyable elements. The format is a fixed header followed
+// by the raw element bytes, so a whole vector goes out in a single writev and comes back in one
+// read into an uninitialized buffer. Files are only portable between machines with the same
+// endianness and the same layout of T.
+
+struct VectorFileHeader {
+	static constexpr uint64_t kMagic = 0x5645435f42494e31;  // "VEC_BIN1"
+
+	uint64_t magic = kMagic;
+
+	uint64_t element_size = 0;
+
+	uint64_t size = 0;
+};
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void WriteTo(int fd, const Vector<T, Allocator, GrowthPolicy>& vector);
+
+// Replaces the contents of vector. On failure vector is left empty. The size in the header is
+// not trusted: memory grows with the bytes actually read, so a corrupt header cannot make it
+// allocate more than the input holds
+template<typename T, typename Allocator, typename GrowthPolicy>
+void ReadFrom(int fd, Vector<T, Allocator, GrowthPolicy>& vector);
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void WriteTo(std::ostream& out, const Vector<T, Allocator, GrowthPolicy>& vector);
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void ReadFrom(std::istream& in, Vector<T, Allocator, GrowthPolicy>& vector);
+
+// Reads a vector written by WriteTo piece by piece, for inputs that should not be loaded at once.
+// Each chunk is read straight into the spare capacity of the destination vector.
+template<typename T>
+class ChunkedReader {
+	static_assert(std::is_trivially_copyable_v<T>, "Binary I/O requires a trivially copyable type");
+
+public:
+	// Reads and validates the header; the caller keeps ownership of fd
+	explicit ChunkedReader(int fd);
+
+	size_t Remaining() const noexcept;
+
+	// Appends up to max_elements elements to vector and returns how many were read, 0 at the end
+	template<typename Allocator, typename GrowthPolicy>
+	size_t ReadChunk(Vector<T, Allocator, GrowthPolicy>& vector, size_t max_elements);
+
+private:
+	int fd_;
+
+	size_t remaining_;
+};
+
+namespace vector_io_detail {
+
+	template<typename T>
+	void CheckHeader(const VectorFileHeader& header) {
+		if (header.magic != VectorFileHeader::kMagic || header.element_size != sizeof(T)) {
+			throw std::runtime_error("Vector binary I/O: incompatible header");
+		}
+		if (header.size > SIZE_MAX / sizeof(T)) {
+			throw std::runtime_error("Vector binary I/O: size out of range");
+		}
+	}
+
+	// Bytes ReadFrom(fd) reads at a time when the input size is unknown
+	inline constexpr size_t kReadChunkBytes = size_t{1} << 20;
+
+	// Bytes between the offset of fd and the end of the file, SIZE_MAX unless fd is a seekable regular file
+	inline size_t BytesLeft(int fd) noexcept {
+		struct stat st;
+		off_t offset = lseek(fd, 0, SEEK_CUR);
+		if (offset < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+			return SIZE_MAX;
+		}
+		return st.st_size > offset ? static_cast<size_t>(st.st_size - offset) : 0;
+	}
+
+	[[noreturn]] inline void ThrowErrno(const char* what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	// Reads exactly size bytes unless the input ends first; returns the number of bytes read
+	inline size_t ReadFull(int fd, void* buf, size_t size) {
+		size_t done = 0;
+		while (done < size) {
+			ssize_t n = read(fd, static_cast<char*>(buf) + done, size - done);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				ThrowErrno("Vector binary I/O: read");
+			}
+			if (n == 0) {
+				break;
+			}
+			done += static_cast<size_t>(n);
+		}
+		return done;
+	}
+
+	// Grows vector by count elements without initializing them when T allows it. Capacity grows
+	// through GrowthPolicy, so extending chunk by chunk reallocates a logarithmic number of times
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	T* Extend(Vector<T, Allocator, GrowthPolicy>& vector, size_t count) {
+		size_t old_size = vector.Size();
+		if (old_size + count > vector.Capacity()) {
+			vector.Reserve(GrowthPolicy::NextCapacity(vector.Capacity(), old_size + count, sizeof(T)));
+		}
+		if constexpr (std::is_trivially_default_constructible_v<T>) {
+			vector.ResizeUninitialized(old_size + count);
+		}
+		else {
+			vector.ResizeDefaultInit(old_size + count);
+		}
+		return vector.Data() + old_size;
+	}
+
+	// Drops the elements from new_size on without constructing anything
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void Truncate(Vector<T, Allocator, GrowthPolicy>& vector, size_t new_size) noexcept {
+		assert(new_size <= vector.Size());
+		if constexpr (std::is_trivially_default_constructible_v<T>) {
+			vector.ResizeUninitialized(new_size);
+		}
+		else {
+			vector.ResizeDefaultInit(new_size);
+		}
+	}
+
+}//end namespace vector_io_detail
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void WriteTo(int fd, const Vector<T, Allocator, GrowthPolicy>& vector) {
+	static_assert(std::is_trivially_copyable_v<T>, "Binary I/O requires a trivially copyable type");
+
+	VectorFileHeader header;
+	header.element_size = sizeof(T);
+	header.size = vector.Size();
+
+	iovec parts[2] = {
+		{&header, sizeof(header)},
+		{const_cast<T*>(vector.Data()), vector.Size() * sizeof(T)},
+	};
+	iovec* part = parts;
+	int count = vector.Size() != 0 ? 2 : 1;
+	while (count > 0) {
+		ssize_t n = writev(fd, part, count);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			vector_io_detail::ThrowErrno("Vector binary I/O: writev");
+		}
+		// Skip what went out and retry the rest after a partial write
+		auto written = static_cast<size_t>(n);
+		while (count > 0 && written >= part->iov_len) {
+			written -= part->iov_len;
+			++part;
+			--count;
+		}
+		if (count > 0) {
+			part->iov_base = static_cast<char*>(part->iov_base) + written;
+			part->iov_len -= written;
+		}
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void ReadFrom(int fd, Vector<T, Allocator, GrowthPolicy>& vector) {
+	ChunkedReader<T> reader(fd);
+	vector.Clear();
+	try {
+		// A regular file is read in one chunk one element longer than it holds, so a header claiming
+		// more fails on the first read. Anything else goes in bounded chunks, so a short input fails
+		// at its end instead of after reserving the claimed size
+		size_t available = vector_io_detail::BytesLeft(fd);
+		size_t chunk = available != SIZE_MAX ? available / sizeof(T) + 1
+		                                     : std::max<size_t>(1, vector_io_detail::kReadChunkBytes / sizeof(T));
+		vector.Reserve(std::min(reader.Remaining(), chunk));
+		while (reader.ReadChunk(vector, chunk) != 0) {
+		}
+	}
+	catch (...) {
+		vector.Clear();
+		throw;
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void WriteTo(std::ostream& out, const Vector<T, Allocator, GrowthPolicy>& vector) {
+	static_assert(std::is_trivially_copyable_v<T>, "Binary I/O requires a trivially copyable type");
+
+	VectorFileHeader header;
+	header.element_size = sizeof(T);
+	header.size = vector.Size();
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(vector.Data()), static_cast<std::streamsize>(vector.Size() * sizeof(T)));
+	if (!out) {
+		throw std::runtime_error("Vector binary I/O: stream write failed");
+	}
+}
+
+template<typename T, typename Allocator, typename GrowthPolicy>
+void ReadFrom(std::istream& in, Vector<T, Allocator, GrowthPolicy>& vector) {
+	static_assert(std::is_trivially_copyable_v<T>, "Binary I/O requires a trivially copyable type");
+
+	VectorFileHeader header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		throw std::runtime_error("Vector binary I/O: missing header");
+	}
+	vector_io_detail::CheckHeader<T>(header);
+
+	vector.Clear();
+	try {
+		auto size = static_cast<size_t>(header.size);
+		T* dest = vector_io_detail::Extend(vector, size);
+		if (!in.read(reinterpret_cast<char*>(dest), static_cast<std::streamsize>(size * sizeof(T)))) {
+			throw std::runtime_error("Vector binary I/O: unexpected end of input");
+		}
+	}
+	catch (...) {
+		vector.Clear();
+		throw;
+	}
+}
+
+template<typename T>
+ChunkedReader<T>::ChunkedReader(int fd)
+	: fd_(fd)
+{
+	VectorFileHeader header;
+	if (vector_io_detail::ReadFull(fd_, &header, sizeof(header)) != sizeof(header)) {
+		throw std::runtime_error("Vector binary I/O: missing header");
+	}
+	vector_io_detail::CheckHeader<T>(header);
+	remaining_ = static_cast<size_t>(header.size);
+}
+
+template<typename T>
+size_t ChunkedReader<T>::Remaining() const noexcept {
+	return remaining_;
+}
+
+template<typename T>
+template<typename Allocator, typename GrowthPolicy>
+size_t ChunkedReader<T>::ReadChunk(Vector<T, Allocator, GrowthPolicy>& vector, size_t max_elements) {
+	size_t count = std::min(max_elements, remaining_);
+	if (count == 0) {
+		return 0;
+	}
+	size_t old_size = vector.Size();
+	T* dest = vector_io_detail::Extend(vector, count);
+	size_t bytes = vector_io_detail::ReadFull(fd_, dest, count * sizeof(T));
+	size_t read_elements = bytes / sizeof(T);
+	if (read_elements != count) {
+		vector_io_detail::Truncate(vector, old_size + read_elements);
+		remaining_ = 0;
+		throw std::runtime_error("Vector binary I/O: unexpected end of input");
+	}
+	remaining_ -= count;
+	return count;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+// Allocation statistics for Vector, compiled in only when ADVANCED_VECTOR_ENABLE_STATS is defined.
+// Without it the hooks expand to nothing and Vector carries no extra state.
+//
+// Counters are grouped by a tag set with Vector::SetStatsTag, typically ADVANCED_VECTOR_CALL_SITE:
+//
+//	Vector<Record> records;
+//	records.SetStatsTag(ADVANCED_VECTOR_CALL_SITE);
+//	...
+//	VectorStats::Dump(std::cerr);
+
+#define ADVANCED_VECTOR_STRINGIFY_IMPL(x) #x
+#define ADVANCED_VECTOR_STRINGIFY(x) ADVANCED_VECTOR_STRINGIFY_IMPL(x)
+#define ADVANCED_VECTOR_CALL_SITE __FILE__ ":" ADVANCED_VECTOR_STRINGIFY(__LINE__)
+
+#ifdef ADVANCED_VECTOR_ENABLE_STATS
+
+#define ADVANCED_VECTOR_STATS(...) __VA_ARGS__
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+struct VectorStatsCounters {
+	std::atomic<uint64_t> allocations{0};
+
+	std::atomic<uint64_t> reallocations{0};
+
+	// Reallocations the allocator did by resizing the buffer, with no new buffer and no elements moved
+	std::atomic<uint64_t> in_place_reallocations{0};
+
+	// Bytes of existing elements carried over to a new buffer on reallocation
+	std::atomic<uint64_t> bytes_moved{0};
+
+	// Elements copied on reallocation because their move constructor may throw
+	std::atomic<uint64_t> elements_copied{0};
+
+	std::atomic<uint64_t> peak_capacity_bytes{0};
+
+	void RecordAllocation(uint64_t capacity_bytes) noexcept;
+
+	void RecordReallocation(uint64_t capacity_bytes, uint64_t moved_bytes, uint64_t copied_elements) noexcept;
+
+	void RecordInPlaceReallocation(uint64_t capacity_bytes) noexcept;
+
+private:
+	void RecordCapacity(uint64_t capacity_bytes) noexcept;
+};
+
+struct VectorStatsSnapshot {
+	uint64_t allocations = 0;
+
+	uint64_t reallocations = 0;
+
+	uint64_t in_place_reallocations = 0;
+
+	uint64_t bytes_moved = 0;
+
+	uint64_t elements_copied = 0;
+
+	uint64_t peak_capacity_bytes = 0;
+};
+
+class VectorStats {
+public:
+	static constexpr const char* kUntagged = "untagged";
+
+	// Counters for tag, created on first use. The reference stays valid for the program lifetime
+	static VectorStatsCounters& ForTag(const std::string& tag);
+
+	static VectorStatsCounters& Untagged();
+
+	static std::map<std::string, VectorStatsSnapshot> Snapshot();
+
+	static void Dump(std::ostream& out);
+
+	static void Reset();
+
+private:
+	struct Registry {
+		std::mutex mutex;
+
+		// std::map never moves its nodes, so handed out references stay valid
+		std::map<std::string, VectorStatsCounters> counters;
+	};
+
+	static Registry& GetRegistry();
+};
+
+inline void VectorStatsCounters::RecordAllocation(uint64_t capacity_bytes) noexcept {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	RecordCapacity(capacity_bytes);
+}
+
+inline void VectorStatsCounters::RecordCapacity(uint64_t capacity_bytes) noexcept {
+	uint64_t peak = peak_capacity_bytes.load(std::memory_order_relaxed);
+	while (peak < capacity_bytes
+	       && !peak_capacity_bytes.compare_exchange_weak(peak, capacity_bytes, std::memory_order_relaxed)) {
+	}
+}
+
+inline void VectorStatsCounters::RecordReallocation(uint64_t capacity_bytes, uint64_t moved_bytes,
+                                                    uint64_t copied_elements) noexcept {
+	RecordAllocation(capacity_bytes);
+	reallocations.fetch_add(1, std::memory_order_relaxed);
+	bytes_moved.fetch_add(moved_bytes, std::memory_order_relaxed);
+	elements_copied.fetch_add(copied_elements, std::memory_order_relaxed);
+}
+
+inline void VectorStatsCounters::RecordInPlaceReallocation(uint64_t capacity_bytes) noexcept {
+	RecordCapacity(capacity_bytes);
+	reallocations.fetch_add(1, std::memory_order_relaxed);
+	in_place_reallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline VectorStatsCounters& VectorStats::ForTag(const std::string& tag) {
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.mutex);
+	return registry.counters[tag];
+}
+
+inline VectorStatsCounters& VectorStats::Untagged() {
+	static VectorStatsCounters& counters = ForTag(kUntagged);
+	return counters;
+}
+
+inline std::map<std::string, VectorStatsSnapshot> VectorStats::Snapshot() {
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.mutex);
+	std::map<std::string, VectorStatsSnapshot> result;
+	for (const auto& [tag, counters] : registry.counters) {
+		VectorStatsSnapshot& snapshot = result[tag];
+		snapshot.allocations = counters.allocations.load(std::memory_order_relaxed);
+		snapshot.reallocations = counters.reallocations.load(std::memory_order_relaxed);
+		snapshot.in_place_reallocations = counters.in_place_reallocations.load(std::memory_order_relaxed);
+		snapshot.bytes_moved = counters.bytes_moved.load(std::memory_order_relaxed);
+		snapshot.elements_copied = counters.elements_copied.load(std::memory_order_relaxed);
+		snapshot.peak_capacity_bytes = counters.peak_capacity_bytes.load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+inline void VectorStats::Dump(std::ostream& out) {
+	for (const auto& [tag, snapshot] : Snapshot()) {
+		out << tag
+		    << ": allocations=" << snapshot.allocations
+		    << " reallocations=" << snapshot.reallocations
+		    << " in_place_reallocations=" << snapshot.in_place_reallocations
+		    << " bytes_moved=" << snapshot.bytes_moved
+		    << " elements_copied=" << snapshot.elements_copied
+		    << " peak_capacity_bytes=" << snapshot.peak_capacity_bytes << '\n';
+	}
+}
+
+inline void VectorStats::Reset() {
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.mutex);
+	for (auto& [tag, counters] : registry.counters) {
+		counters.allocations.store(0, std::memory_order_relaxed);
+		counters.reallocations.store(0, std::memory_order_relaxed);
+		counters.in_place_reallocations.store(0, std::memory_order_relaxed);
+		counters.bytes_moved.store(0, std::memory_order_relaxed);
+		counters.elements_copied.store(0, std::memory_order_relaxed);
+		counters.peak_capacity_bytes.store(0, std::memory_order_relaxed);
+	}
+}
+
+inline VectorStats::Registry& VectorStats::GetRegistry() {
+	// Leaked on purpose so that vectors destroyed during static destruction can still report
+	static Registry* registry = new Registry;
+	return *registry;
+}
+
+#else
+
+#define ADVANCED_VECTOR_STATS(...)
+
+#endif